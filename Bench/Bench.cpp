@@ -0,0 +1,430 @@
+// Frame-time benchmark for the library, runs without a display (see Headless).
+//
+// Builds scripted scenes and reports, per scene:
+//   - WindowManager::Draw time per frame (average, min, max)
+//   - WindowManager::HitTest time, with and without the spatial index
+//   - SDL calls submitted per frame by the primitive batch (texture copies and text
+//     aren't included, see -p for all of them)
+//   - live textures created by the library
+//   - controls drawn and culled in the last frame
+//
+// Usage: coreui-bench [-f frames] [-s WxH] [-r] [-p] [-i] [scene...]
+//   -r: retained mode, the topmost window is invalidated every frame
+//   -p: print the profiler stats of each scene's last frame (needs COREUI_PROFILE)
+//   -i: only check that retained mode goes idle (no repaint, waits for the next timer),
+//       exit status 1 if it doesn't
+//   scenes: windows, children, tree, textbox, menu (default: all)
+
+#include "Common.h"
+#include "Core/Headless.h"
+#include "Core/Tooltip.h"
+#include "Core/WindowManager.h"
+#include "Core/Window.h"
+#include "Core/DrawBatch.h"
+#include "Widgets/Button.h"
+#include "Widgets/Label.h"
+#include "Widgets/Menu.h"
+#include "Widgets/MenuItem.h"
+#include "Widgets/TextBox.h"
+#include "Widgets/Tree.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CoreUI;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	struct Options
+	{
+		int frames = 100;
+		int width = 1280;
+		int height = 800;
+		bool retained = false;
+		bool profile = false;
+		bool idle = false;
+		std::vector<std::string> scenes;
+	};
+
+	// Windows created by a scene, removed in reverse order (children first)
+	class Scene
+	{
+	public:
+		explicit Scene(Headless & headless) : m_headless(headless) {}
+		~Scene()
+		{
+			for (auto it = m_ids.rbegin(); it != m_ids.rend(); ++it)
+			{
+				WINMGR().RemoveWindow(it->c_str());
+			}
+			SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+		}
+
+		WindowPtr AddWindow(const std::string & id, Rect pos, WindowPtr parent = nullptr, CreationFlags flags = WIN_DEFAULT)
+		{
+			m_ids.push_back(id);
+			WindowPtr wnd = WINMGR().AddWindow(id.c_str(), parent, pos, flags);
+			wnd->SetText(id.c_str());
+			return wnd;
+		}
+
+		RendererRef GetRenderer() const { return m_headless.GetRenderer(); }
+
+	protected:
+		Headless & m_headless;
+		std::vector<std::string> m_ids;
+	};
+
+	void BuildWindows(Scene & scene, int count)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			std::string id = "wnd" + std::to_string(i);
+			WindowPtr wnd = scene.AddWindow(id, Rect((i * 37) % 1000, (i * 23) % 600, 240, 180));
+
+			for (int b = 0; b < 4; ++b)
+			{
+				std::string buttonId = "btn" + std::to_string(b);
+				wnd->AddControl(Button::Create(buttonId.c_str(), scene.GetRenderer(), Rect(5, 5 + (b * 30), 100, 26), buttonId.c_str()));
+			}
+			wnd->AddControl(Label::CreateSingle("label", scene.GetRenderer(), Rect(110, 5, 120, 20), id.c_str()));
+		}
+	}
+
+	void BuildChildren(Scene & scene, int count)
+	{
+		WindowPtr parent = scene.AddWindow("parent", Rect(0, 0, 1200, 760));
+		for (int i = 0; i < count; ++i)
+		{
+			std::string id = "child" + std::to_string(i);
+			WindowPtr child = scene.AddWindow(id, Rect((i % 10) * 150, (i / 10) * 110, 140, 100), parent);
+
+			// Nested one more level
+			scene.AddWindow(id + ".inner", Rect(5, 5, 120, 60), child, WIN_CANMOVE);
+		}
+	}
+
+	void AddTreeLevel(Tree & tree, TreeNodeRef parent, int depth, int fanout)
+	{
+		for (int i = 0; i < fanout; ++i)
+		{
+			std::string label = "Node " + std::to_string(depth) + "." + std::to_string(i);
+			TreeNodeRef node = tree.AddNode(label.c_str(), parent);
+			if (depth > 1)
+			{
+				AddTreeLevel(tree, node, depth - 1, fanout);
+				tree.OpenNode(node);
+			}
+		}
+	}
+
+	void BuildTree(Scene & scene, int depth, int fanout)
+	{
+		WindowPtr wnd = scene.AddWindow("tree", Rect(10, 10, 600, 700));
+		TreePtr tree = Tree::CreateFill("tree", scene.GetRenderer());
+		wnd->AddControl(tree);
+		AddTreeLevel(*tree, nullptr, depth, fanout);
+	}
+
+	void BuildTextBox(Scene & scene, int lineCount)
+	{
+		WindowPtr wnd = scene.AddWindow("text", Rect(10, 10, 800, 700));
+		TextBoxPtr text = TextBox::CreateFill("text", scene.GetRenderer(), "");
+		wnd->AddControl(text);
+
+		std::vector<std::string> lines;
+		std::vector<const char *> ptrs;
+		lines.reserve(lineCount);
+		for (int i = 0; i < lineCount; ++i)
+		{
+			lines.push_back("Line " + std::to_string(i) + ": The quick brown fox jumps over the lazy dog");
+			ptrs.push_back(lines.back().c_str());
+		}
+		text->Append(ptrs.data(), ptrs.size());
+	}
+
+	void BuildMenu(Scene & scene, int menuCount, int itemCount)
+	{
+		WindowPtr wnd = scene.AddWindow("menu", Rect(10, 10, 800, 600));
+		MenuPtr menu = Menu::Create(scene.GetRenderer(), "menu");
+		wnd->SetMenu(menu);
+
+		MenuItemPtr first;
+		for (int m = 0; m < menuCount; ++m)
+		{
+			std::string id = "menu" + std::to_string(m);
+			MenuItemPtr item = menu->AddMenuItem(id.c_str(), ("&Menu " + std::to_string(m)).c_str());
+			for (int i = 0; i < itemCount; ++i)
+			{
+				std::string sub = id + "." + std::to_string(i);
+				item->AddMenuItem(sub.c_str(), ("Item " + std::to_string(i)).c_str());
+			}
+			if (!first)
+			{
+				first = item;
+			}
+		}
+
+		wnd->SetActive();
+		menu->OpenMenu(first.get());
+	}
+
+	struct Result
+	{
+		double drawAvg = 0;
+		double drawMin = 0;
+		double drawMax = 0;
+		double hitIndexed = 0; // Microseconds per hit test
+		double hitLinear = 0;
+		double submits = 0; // Draw batch submits per frame
+		size_t textures = 0;
+		uint32_t drawnControls = 0; // Last frame
+		uint32_t culledControls = 0;
+	};
+
+	double TimeHitTests(const std::vector<Point> & points)
+	{
+		Clock::time_point start = Clock::now();
+		for (auto pt : points)
+		{
+			WINMGR().HitTest(&pt);
+		}
+		return ElapsedMs(start) * 1000.0 / points.size();
+	}
+
+	Result Measure(Headless & headless, const Options & options)
+	{
+		Result result;
+		WindowManager & mgr = WINMGR();
+		mgr.SetRetainedMode(options.retained);
+
+		// First frame creates the caches, not part of the measurement
+		mgr.Draw();
+		headless.Flush();
+		SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+		size_t submits = BATCH().GetSubmitCount();
+		result.drawMin = 1e9;
+		for (int i = 0; i < options.frames; ++i)
+		{
+			if (options.retained)
+			{
+				WindowPtr top = mgr.GetWindowList(nullptr).back();
+				top->Invalidate();
+			}
+
+			Clock::time_point start = Clock::now();
+			mgr.Draw();
+			headless.Flush();
+			double elapsed = ElapsedMs(start);
+
+			result.drawAvg += elapsed;
+			result.drawMin = std::min(result.drawMin, elapsed);
+			result.drawMax = std::max(result.drawMax, elapsed);
+			SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+		}
+		result.drawAvg /= options.frames;
+		result.drawnControls = mgr.GetDrawnControls();
+		result.culledControls = mgr.GetCulledControls();
+		result.submits = (double)(BATCH().GetSubmitCount() - submits) / options.frames;
+
+		std::mt19937 random(42);
+		std::uniform_int_distribution<int> x(0, options.width - 1);
+		std::uniform_int_distribution<int> y(0, options.height - 1);
+		std::vector<Point> points;
+		for (int i = 0; i < 10000; ++i)
+		{
+			points.push_back(Point(x(random), y(random)));
+		}
+
+		mgr.SetHitTestIndex(true);
+		result.hitIndexed = TimeHitTests(points);
+		mgr.SetHitTestIndex(false);
+		result.hitLinear = TimeHitTests(points);
+		mgr.SetHitTestIndex(true);
+
+		result.textures = GetTextureCount();
+		return result;
+	}
+
+	// Retained mode with nothing changing: once a frame is drawn, the next one repaints
+	// nothing and the host can sleep until the next timer
+	bool CheckIdle(Headless & headless)
+	{
+		Scene scene(headless);
+		WindowPtr wnd = scene.AddWindow("idle", Rect(10, 10, 400, 300));
+		ButtonPtr button = Button::Create("button", scene.GetRenderer(), Rect(5, 5, 100, 26), "Button");
+		wnd->AddControl(button);
+		button->SetFocus(button.get());
+
+		WindowPtr treeWnd = scene.AddWindow("idleTree", Rect(420, 10, 300, 300));
+		TreePtr tree = Tree::CreateFill("tree", scene.GetRenderer());
+		treeWnd->AddControl(tree);
+		AddTreeLevel(*tree, nullptr, 2, 5);
+		tree->SelectNode(tree->AddNode("Selected"));
+
+		TOOLTIP().Show(button.get(), Point(50, 100), "Tooltip");
+
+		WindowManager & mgr = WINMGR();
+		Uint32 timer = mgr.AddTimer(5000);
+		mgr.SetRetainedMode(true);
+		mgr.Draw();
+		headless.Flush();
+
+		bool repainted = mgr.Draw();
+		headless.Flush();
+
+		Uint32 now = SDL_GetTicks();
+		Uint32 deadline = now;
+		bool hasDeadline = mgr.GetNextDeadline(deadline);
+		bool needsRedraw = mgr.NeedsRedraw();
+		int timeout = mgr.GetWaitTimeout(now);
+		bool idle = !repainted && !needsRedraw && hasDeadline && timeout == (int)(deadline - now);
+
+		mgr.DeleteTimer(timer);
+		TOOLTIP().Hide(button.get());
+		SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+		printf("idle: second frame %s, NeedsRedraw %s, wait %d ms, next timer in %d ms: %s\n",
+			repainted ? "repainted" : "not repainted", needsRedraw ? "true" : "false", timeout,
+			hasDeadline ? (int)(deadline - now) : -1, idle ? "ok" : "FAILED");
+		return idle;
+	}
+
+	struct SceneInfo
+	{
+		const char * name;
+		std::function<void(Scene &)> build;
+	};
+
+	bool ParseOptions(int argc, char * argv[], Options & options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char * arg = argv[i];
+			if (!strcmp(arg, "-f") && i + 1 < argc)
+			{
+				options.frames = std::max(1, atoi(argv[++i]));
+			}
+			else if (!strcmp(arg, "-s") && i + 1 < argc)
+			{
+				if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2)
+					return false;
+			}
+			else if (!strcmp(arg, "-r"))
+			{
+				options.retained = true;
+			}
+			else if (!strcmp(arg, "-p"))
+			{
+				options.profile = true;
+			}
+			else if (!strcmp(arg, "-i"))
+			{
+				options.idle = true;
+			}
+			else if (arg[0] == '-')
+			{
+				return false;
+			}
+			else
+			{
+				options.scenes.push_back(arg);
+			}
+		}
+		return options.width > 0 && options.height > 0;
+	}
+
+	void PrintFrameStats(const FrameStats & stats)
+	{
+		printf("  RenderCopy %u, geometry %u, primitives %u, draw color %u, clip rect %u, textures %u, glyphs %u\n",
+			stats.renderCopies, stats.geometryCalls, stats.primitiveCalls, stats.drawColorChanges,
+			stats.clipRectChanges, stats.texturesCreated, stats.glyphsRendered);
+		for (size_t i = 0; i < stats.scopes.size() && i < 5; ++i)
+		{
+			const ScopeStats & scope = stats.scopes[i];
+			printf("  %10.3f ms %6u  %s\n", scope.ms, scope.calls, scope.name.c_str());
+		}
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		fprintf(stderr, "Usage: %s [-f frames] [-s WxH] [-r] [-p] [-i] [windows|children|tree|textbox|menu...]\n", argv[0]);
+		return 2;
+	}
+
+	const SceneInfo scenes[] = {
+		{ "windows", [](Scene & s) { BuildWindows(s, 200); } },
+		{ "children", [](Scene & s) { BuildChildren(s, 60); } },
+		{ "tree", [](Scene & s) { BuildTree(s, 6, 6); } },
+		{ "textbox", [](Scene & s) { BuildTextBox(s, 100000); } },
+		{ "menu", [](Scene & s) { BuildMenu(s, 8, 20); } },
+	};
+
+	try
+	{
+		if (options.profile && !Profiler::IsEnabled())
+		{
+			fprintf(stderr, "-p: built without COREUI_PROFILE\n");
+			return 2;
+		}
+
+		Headless headless(options.width, options.height);
+
+		if (options.idle)
+		{
+			return CheckIdle(headless) ? 0 : 1;
+		}
+
+		printf("%dx%d, %d frames, %s mode\n", options.width, options.height, options.frames, options.retained ? "retained" : "immediate");
+		printf("%-10s %10s %10s %10s %12s %12s %14s %9s %15s\n",
+			"scene", "draw avg", "draw min", "draw max", "hit indexed", "hit linear", "batch submits", "textures", "controls");
+		printf("%-10s %10s %10s %10s %12s %12s %14s %9s %15s\n",
+			"", "(ms)", "(ms)", "(ms)", "(us)", "(us)", "/frame", "", "drawn/culled");
+
+		for (auto & info : scenes)
+		{
+			if (!options.scenes.empty() &&
+				std::find(options.scenes.begin(), options.scenes.end(), info.name) == options.scenes.end())
+			{
+				continue;
+			}
+
+			Scene scene(headless);
+			info.build(scene);
+			Result r = Measure(headless, options);
+
+			printf("%-10s %10.3f %10.3f %10.3f %12.3f %12.3f %14.1f %9zu %7u/%-7u\n",
+				info.name, r.drawAvg, r.drawMin, r.drawMax, r.hitIndexed, r.hitLinear, r.submits, r.textures,
+				r.drawnControls, r.culledControls);
+			if (options.profile)
+			{
+				PrintFrameStats(WINMGR().GetFrameStats());
+			}
+		}
+	}
+	catch (std::exception & e)
+	{
+		fprintf(stderr, "Error: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
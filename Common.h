@@ -21,6 +21,11 @@ namespace CoreUI
 	using CreationFlags = uint32_t;
 	using EventCode = Sint32;
 
+	// Id of a class declared with DECLARE_EVENT_CLASS_NAME, assigned on first use so
+	// classes outside the library get one too.  0 is never assigned.
+	using EventClass = uint32_t;
+	DllExport EventClass NewEventClass();
+
 	enum HitZone : uint32_t {
 		HIT_NOTHING				= 0x0,
 		HIT_TITLEBAR			= 0x1,
@@ -87,6 +92,8 @@ namespace CoreUI
 
 		WIN_NOACTIVE = 4096, // Window is not activated on click
 
+		WIN_CACHED = 8192, // Top level window is rendered to an offscreen texture, redrawn only when its content changes
+
 		WIN_DEFAULT = WIN_SYSMENU | WIN_MINMAX | WIN_CANMOVE | WIN_CANRESIZE,
 		WIN_DEFAULTDLG = WIN_SYSMENU | WIN_MINMAX | WIN_CANMOVE | WIN_NOSCROLL | WIN_DIALOG,
 
@@ -185,6 +192,10 @@ namespace CoreUI
 	using CursorPtr = std::unique_ptr<SDL_Cursor, sdl_deleter>;
 	using TexturePtr = std::shared_ptr<SDL_Texture>;
 
+	// Owns a texture created by the library, counted by GetTextureCount()
+	DllExport TexturePtr MakeTexture(TextureRef texture);
+	DllExport size_t GetTextureCount();
+
 	template <typename T>
 	T clip(const T& n, const T& lower, const T& upper) {
 		return (std::max)(lower, (std::min)(n, upper));
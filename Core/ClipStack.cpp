@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include "SDL.h"
+#include "ClipStack.h"
+#include "DrawBatch.h"
+#include "Profiler.h"
+
+namespace CoreUI
+{
+	ClipStack & ClipStack::Get()
+	{
+		static ClipStack stack;
+		return stack;
+	}
+
+	bool ClipStack::Push(RendererRef renderer, RectRef rect, bool merge)
+	{
+		if (renderer != m_renderer)
+		{
+			m_renderer = renderer;
+			m_appliedValid = false;
+		}
+
+		const State & current = m_stack.back();
+		State state;
+		state.origin = current.origin;
+		if (rect == nullptr)
+		{
+			state.clipped = !m_baseClip.IsEmpty();
+			state.rect = m_baseClip;
+		}
+		else
+		{
+			Rect currentRect = current.rect;
+			state.clipped = true;
+			state.rect = (merge && current.clipped) ? rect->IntersectRect(&currentRect) : *rect;
+		}
+
+		m_stack.push_back(state);
+		Apply(state);
+
+#ifdef DEBUG_CLIP
+		if (state.clipped)
+		{
+			BATCH().Flush();
+			SDL_SetRenderDrawColor(m_renderer, 255, state.rect.IsEmpty() ? 255 : 0, 0, 255);
+			SDL_RenderDrawRect(m_renderer, &ToTarget(state.rect));
+		}
+#endif
+		return !IsEmpty();
+	}
+
+	void ClipStack::Pop()
+	{
+		// Called from destructors, a mismatched pop is ignored
+		if (m_stack.size() < 2 || m_stack.back().target)
+			return;
+
+		m_stack.pop_back();
+		Apply(m_stack.back());
+	}
+
+	void ClipStack::PushTarget(RendererRef renderer, const Point & origin)
+	{
+		// SDL_SetRenderTarget was just called, the new target isn't clipped
+		m_renderer = renderer;
+		State state;
+		state.target = true;
+		state.origin = origin;
+		m_stack.push_back(state);
+		m_applied = state;
+		m_appliedValid = true;
+	}
+
+	void ClipStack::PopTarget()
+	{
+		if (m_stack.size() < 2 || !m_stack.back().target)
+			return;
+
+		m_stack.pop_back();
+
+		// The previous target's clip is unknown after switching back
+		m_appliedValid = false;
+		Apply(m_stack.back());
+	}
+
+	void ClipStack::Reset()
+	{
+		m_appliedValid = false;
+	}
+
+	void ClipStack::Apply(const State & state)
+	{
+		// Nothing visible, draws are culled and SDL keeps its current clip
+		if (state.clipped && state.rect.IsEmpty())
+			return;
+
+		if (m_appliedValid && state == m_applied)
+			return;
+
+		if (m_renderer == nullptr)
+			return;
+
+		// Queued primitives were submitted under the previous clip rect
+		BATCH().Flush();
+		PROFILE_COUNT(clipRectChanges);
+		Rect clip(state.rect.x - state.origin.x, state.rect.y - state.origin.y, state.rect.w, state.rect.h);
+		SDL_RenderSetClipRect(m_renderer, state.clipped ? &clip : nullptr);
+		m_applied = state;
+		m_appliedValid = true;
+	}
+}
\ No newline at end of file
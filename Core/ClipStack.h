@@ -0,0 +1,94 @@
+#pragma once
+#include "Common.h"
+#include "Rect.h"
+#include <vector>
+
+namespace CoreUI
+{
+	// Clip rect of the renderer, tracked in memory.  ClipRect scopes push and pop
+	// entries; SDL is only called when the effective clip actually changes.
+	//
+	// An empty clip (nothing visible) is never sent to SDL, which would take it as
+	// 'no clipping'.  Draws are culled instead: everything drawing through the
+	// library checks IsVisible() before reaching SDL.
+	//
+	// Each render target has its own clip in SDL, RenderTarget starts a new level.
+	// Clip rects are always in screen coordinates.  A target drawn at another screen
+	// position has an origin, subtracted from everything sent to SDL while it is current.
+	class DllExport ClipStack
+	{
+	public:
+		virtual ~ClipStack() = default;
+		ClipStack(const ClipStack&) = delete;
+		ClipStack& operator=(const ClipStack&) = delete;
+		ClipStack(ClipStack&&) = delete;
+		ClipStack& operator=(ClipStack&&) = delete;
+
+		static ClipStack & Get();
+
+		// Clips to 'rect', or to its intersection with the current clip if 'merge' is set.
+		// A null rect resets to the base clip.  Returns false if nothing is visible.
+		bool Push(RendererRef renderer, RectRef rect, bool merge);
+		void Pop();
+
+		// New render target, starts unclipped.  'origin' is the screen position of its top left corner.
+		void PushTarget(RendererRef renderer, const Point & origin = Point());
+		void PopTarget();
+
+		// Forget what was sent to SDL, i.e. if the host changed the clip rect
+		void Reset();
+
+		bool IsClipped() const { return m_stack.back().clipped; }
+		bool IsEmpty() const { return m_stack.back().clipped && m_stack.back().rect.IsEmpty(); }
+		const Rect & GetClip() const { return m_stack.back().rect; } // Only meaningful if IsClipped()
+
+		// For direct SDL calls: screen coordinates to those of the current render target
+		const Point & GetOrigin() const { return m_stack.back().origin; }
+		Rect ToTarget(const Rect & rect) const
+		{
+			const Point & origin = GetOrigin();
+			return Rect(rect.x - origin.x, rect.y - origin.y, rect.w, rect.h);
+		}
+
+		// False if nothing of 'rect' would be drawn
+		bool IsVisible(const Rect & rect) const
+		{
+			const State & state = m_stack.back();
+			Rect r = rect;
+			return !state.clipped || state.rect.HasIntersection(&r);
+		}
+
+		// Outermost clip region, used in place of 'no clipping' when a null rect is pushed.
+		// Set by the window manager to confine a partial repaint to the damaged area.
+		const Rect & GetBaseClip() const { return m_baseClip; }
+		void SetBaseClip(RectRef rect) { m_baseClip = rect ? *rect : Rect(); }
+
+	protected:
+		ClipStack() : m_stack(1) {}
+
+		struct State
+		{
+			bool clipped = false;
+			Rect rect;
+			bool target = false; // First entry of a render target
+			Point origin; // Of the render target
+
+			bool operator==(const State & rhs) const
+			{
+				return clipped == rhs.clipped && origin.x == rhs.origin.x && origin.y == rhs.origin.y &&
+					(!clipped || (rect.x == rhs.rect.x && rect.y == rhs.rect.y && rect.w == rhs.rect.w && rect.h == rhs.rect.h));
+			}
+		};
+
+		void Apply(const State & state);
+
+		RendererRef m_renderer = nullptr;
+		std::vector<State> m_stack;
+		Rect m_baseClip;
+
+		State m_applied; // Last clip sent to SDL
+		bool m_appliedValid = false;
+	};
+
+	constexpr auto CLIP = &ClipStack::Get;
+}
\ No newline at end of file
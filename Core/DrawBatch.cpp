@@ -0,0 +1,136 @@
+#include "stdafx.h"
+#include "SDL.h"
+#include "DrawBatch.h"
+#include "Profiler.h"
+#include "ClipStack.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace CoreUI
+{
+	DrawBatch & DrawBatch::Get()
+	{
+		static DrawBatch batch;
+		return batch;
+	}
+
+	DrawBatch::Run & DrawBatch::FindRun(RendererRef renderer, RunType type, const Color & col, const Rect & bounds)
+	{
+		if (renderer != m_renderer)
+		{
+			Flush();
+			m_renderer = renderer;
+		}
+
+		// Walk back through the queue while the new primitive doesn't overlap anything
+		size_t lookback = (m_usedRuns < m_maxLookback) ? m_usedRuns : m_maxLookback;
+		for (size_t i = 0; i < lookback; ++i)
+		{
+			Run & run = m_runs[m_usedRuns - 1 - i];
+			if (run.type == type && run.color == col)
+			{
+				run.bounds = run.bounds.UnionRect(&Rect(bounds));
+				return run;
+			}
+
+			if (run.bounds.HasIntersection(&Rect(bounds)))
+			{
+				break;
+			}
+		}
+
+		if (m_usedRuns == m_runs.size())
+		{
+			m_runs.emplace_back();
+		}
+
+		Run & run = m_runs[m_usedRuns++];
+		run.type = type;
+		run.color = col;
+		run.bounds = bounds;
+		run.rects.clear();
+		run.points.clear();
+		return run;
+	}
+
+	void DrawBatch::FillRect(RendererRef renderer, const Rect & rect, const Color & col)
+	{
+		if (rect.w <= 0 || rect.h <= 0 || !CLIP().IsVisible(rect))
+			return;
+
+		FindRun(renderer, RunType::FILL, col, rect).rects.push_back(rect);
+	}
+
+	void DrawBatch::DrawLine(RendererRef renderer, int x1, int y1, int x2, int y2, const Color & col)
+	{
+		if (x1 == x2 || y1 == y2)
+		{
+			// Axis aligned, same pixels as SDL_RenderDrawLine (end point included)
+			Rect line(std::min(x1, x2), std::min(y1, y2), std::abs(x2 - x1) + 1, std::abs(y2 - y1) + 1);
+			FillRect(renderer, line, col);
+		}
+		else
+		{
+			Rect bounds(std::min(x1, x2), std::min(y1, y2), std::abs(x2 - x1) + 1, std::abs(y2 - y1) + 1);
+			if (!CLIP().IsVisible(bounds))
+				return;
+
+			Flush();
+			PROFILE_COUNT(drawColorChanges);
+			SDL_SetRenderDrawColor(renderer, col.r, col.g, col.b, col.a);
+			PROFILE_COUNT(primitiveCalls);
+			const Point & origin = CLIP().GetOrigin();
+			SDL_RenderDrawLine(renderer, x1 - origin.x, y1 - origin.y, x2 - origin.x, y2 - origin.y);
+			++m_submitCount;
+		}
+	}
+
+	void DrawBatch::DrawPoint(RendererRef renderer, int x, int y, const Color & col)
+	{
+		if (!CLIP().IsVisible(Rect(x, y, 1, 1)))
+			return;
+
+		FindRun(renderer, RunType::POINTS, col, Rect(x, y, 1, 1)).points.push_back({ x, y });
+	}
+
+	void DrawBatch::Flush()
+	{
+		// Runs are queued in screen coordinates.  Render targets are only switched
+		// after a flush, the current origin applies to the whole queue.
+		const Point & origin = CLIP().GetOrigin();
+		bool translate = (origin.x != 0 || origin.y != 0);
+
+		for (size_t i = 0; i < m_usedRuns; ++i)
+		{
+			Run & run = m_runs[i];
+			if (translate)
+			{
+				for (Rect & rect : run.rects)
+				{
+					rect.x -= origin.x;
+					rect.y -= origin.y;
+				}
+				for (SDL_Point & point : run.points)
+				{
+					point.x -= origin.x;
+					point.y -= origin.y;
+				}
+			}
+
+			PROFILE_COUNT(drawColorChanges);
+			SDL_SetRenderDrawColor(m_renderer, run.color.r, run.color.g, run.color.b, run.color.a);
+			if (run.type == RunType::FILL)
+			{
+				PROFILE_COUNT(primitiveCalls);
+				SDL_RenderFillRects(m_renderer, run.rects.data(), (int)run.rects.size());
+			}
+			else
+			{
+				PROFILE_COUNT(primitiveCalls);
+				SDL_RenderDrawPoints(m_renderer, run.points.data(), (int)run.points.size());
+			}
+			++m_submitCount;
+		}
+		m_usedRuns = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include "Common.h"
+#include "Color.h"
+#include "Rect.h"
+#include <vector>
+
+namespace CoreUI
+{
+	// Collects solid primitives and submits them grouped by color with SDL_RenderFillRects
+	// and SDL_RenderDrawPoints.  A primitive may join an earlier group of the same color
+	// only if it doesn't overlap anything queued after that group, so the result matches
+	// drawing in submission order.
+	//
+	// Anything that draws directly (textures, clip or target changes) must call Flush() first.
+	class DllExport DrawBatch
+	{
+	public:
+		virtual ~DrawBatch() = default;
+		DrawBatch(const DrawBatch&) = delete;
+		DrawBatch& operator=(const DrawBatch&) = delete;
+		DrawBatch(DrawBatch&&) = delete;
+		DrawBatch& operator=(DrawBatch&&) = delete;
+
+		static DrawBatch & Get();
+
+		void FillRect(RendererRef renderer, const Rect & rect, const Color & col);
+		void DrawLine(RendererRef renderer, int x1, int y1, int x2, int y2, const Color & col);
+		void DrawPoint(RendererRef renderer, int x, int y, const Color & col);
+
+		void Flush();
+
+		size_t GetSubmitCount() const { return m_submitCount; } // SDL calls issued by the batch so far
+
+	protected:
+		DrawBatch() = default;
+
+		enum class RunType { FILL, POINTS };
+
+		struct Run
+		{
+			RunType type;
+			Color color;
+			Rect bounds;
+			std::vector<Rect> rects;
+			std::vector<SDL_Point> points;
+		};
+		using RunList = std::vector<Run>;
+
+		Run & FindRun(RendererRef renderer, RunType type, const Color & col, const Rect & bounds);
+
+		// Number of queued runs checked for a color match
+		static const size_t m_maxLookback = 16;
+
+		RendererRef m_renderer = nullptr;
+		RunList m_runs;
+		size_t m_usedRuns = 0; // Runs are kept when flushing to reuse their buffers
+
+		size_t m_submitCount = 0;
+	};
+
+	constexpr auto BATCH = &DrawBatch::Get;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#include "EventBus.h"
+#include <algorithm>
+#include <atomic>
+
+namespace CoreUI
+{
+	EventClass NewEventClass()
+	{
+		static std::atomic<EventClass> next(1);
+		return next++;
+	}
+
+	EventBus & EventBus::Get()
+	{
+		static EventBus bus;
+		return bus;
+	}
+
+	EventBus::SubscriptionID EventBus::Subscribe(EventClass eventClass, Handler handler, const Widget * source)
+	{
+		if (eventClass == 0)
+		{
+			throw std::invalid_argument("invalid event class");
+		}
+		if (!handler)
+		{
+			throw std::invalid_argument("handler is null");
+		}
+
+		if (eventClass >= m_subscribers.size())
+		{
+			m_subscribers.resize(eventClass + 1);
+		}
+		if (!m_subscribers[eventClass])
+		{
+			m_subscribers[eventClass].reset(new SubscriberList());
+		}
+
+		SubscriptionID id = m_nextID++;
+		m_classes[id] = eventClass;
+		m_subscribers[eventClass]->Add(id, { source, std::move(handler) });
+		return id;
+	}
+
+	void EventBus::Unsubscribe(SubscriptionID id)
+	{
+		auto found = m_classes.find(id);
+		if (found == m_classes.end())
+			return;
+
+		// The handler may be running, then it is removed once the event is delivered
+		m_subscribers[found->second]->Remove(id);
+		m_classes.erase(found);
+	}
+
+	void EventBus::Publish(const WidgetEvent & e)
+	{
+		if (e.eventClass == 0)
+		{
+			throw std::invalid_argument("invalid event class");
+		}
+
+		++m_stats.published;
+		if (e.eventClass >= m_subscribers.size() || !m_subscribers[e.eventClass])
+			return;
+
+		++m_dispatching;
+		m_subscribers[e.eventClass]->ForEach([&](Subscriber & subscriber)
+		{
+			if (subscriber.source == nullptr || subscriber.source == e.source)
+			{
+				subscriber.handler(e);
+			}
+		});
+		--m_dispatching;
+	}
+
+	void EventBus::Post(const WidgetEvent & e, bool coalesce)
+	{
+		if (coalesce)
+		{
+			for (QueuedEvent & queued : m_queue)
+			{
+				if (queued.event.eventClass == e.eventClass && queued.event.code == e.code && queued.event.source == e.source)
+				{
+					queued.event.data = e.data;
+					++m_stats.coalesced;
+					return;
+				}
+			}
+		}
+		m_queue.push_back({ e, false });
+	}
+
+	void EventBus::Dispatch()
+	{
+		// Called from a handler: the queue is being delivered already
+		if (m_dispatching)
+			return;
+
+		// Events posted by handlers wait for the next call
+		m_delivering.clear();
+		m_delivering.swap(m_queue);
+
+		for (size_t i = 0; i < m_delivering.size(); ++i)
+		{
+			if (!m_delivering[i].cancelled)
+			{
+				Publish(m_delivering[i].event);
+			}
+		}
+		m_delivering.clear();
+	}
+
+	void EventBus::Cancel(const Widget * source)
+	{
+		m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+			[source](const QueuedEvent & queued) { return queued.event.source == source; }), m_queue.end());
+
+		for (QueuedEvent & queued : m_delivering)
+		{
+			if (queued.event.source == source)
+			{
+				queued.cancelled = true;
+			}
+		}
+	}
+
+	void EventBus::ClearQueue()
+	{
+		m_queue.clear();
+		for (QueuedEvent & queued : m_delivering)
+		{
+			queued.cancelled = true;
+		}
+	}
+}
\ No newline at end of file
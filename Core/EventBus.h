@@ -0,0 +1,108 @@
+#pragma once
+#include "Common.h"
+#include "Util/SlotList.h"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace CoreUI
+{
+	// Notification sent by a widget, i.e. Button::EVENT_BUTTON_CLICKED
+	struct DllExport WidgetEvent
+	{
+		EventClass eventClass;
+		EventCode code;
+		WidgetRef source;
+		void * data; // Depends on the code, i.e. MenuItemRef for EVENT_MENU_SELECTED
+	};
+
+	struct DllExport EventBusStats
+	{
+		uint32_t published = 0; // Delivered to subscribers
+		uint32_t coalesced = 0; // Change notifications merged into a queued one
+	};
+
+	// In-process delivery of widget notifications.  Subscribers are called directly,
+	// no SDL event queue or event type lookup is involved.  Events posted by widgets
+	// are queued and delivered by Dispatch(), called from WindowManager::Draw().
+	//
+	// The bus isn't thread safe, it is meant for the UI thread.  With the SDL bridge
+	// enabled, posted events are also pushed to the SDL event queue as before, with
+	// the type WINMGR().GetEventType(className).
+	class DllExport EventBus
+	{
+	public:
+		using SubscriptionID = uint32_t;
+		using Handler = std::function<void(const WidgetEvent &)>;
+
+		virtual ~EventBus() = default;
+		EventBus(const EventBus&) = delete;
+		EventBus& operator=(const EventBus&) = delete;
+		EventBus(EventBus&&) = delete;
+		EventBus& operator=(EventBus&&) = delete;
+
+		static EventBus & Get();
+
+		// Events of a class, from any widget or only from 'source'.  The handler may
+		// subscribe and unsubscribe, changes apply to the next event.
+		SubscriptionID Subscribe(EventClass eventClass, Handler handler, const Widget * source = nullptr);
+		template <class T>
+		SubscriptionID Subscribe(Handler handler, const T * source = nullptr)
+		{
+			return Subscribe(T::EventClassID(), std::move(handler), source);
+		}
+		void Unsubscribe(SubscriptionID id);
+
+		// Delivers the event now
+		void Publish(const WidgetEvent & e);
+
+		// Queues the event until the next Dispatch().  With 'coalesce', a queued event
+		// with the same class, code and source takes the new data instead.
+		void Post(const WidgetEvent & e, bool coalesce = false);
+		void Dispatch();
+		size_t GetQueuedCount() const { return m_queue.size(); }
+
+		// Drops the queued events of a widget about to be destroyed
+		void Cancel(const Widget * source);
+		void ClearQueue();
+
+		void SetSDLBridge(bool enable) { m_sdlBridge = enable; }
+		bool IsSDLBridge() const { return m_sdlBridge; }
+
+		const EventBusStats & GetStats() const { return m_stats; }
+		void ResetStats() { m_stats = EventBusStats(); }
+
+	protected:
+		EventBus() = default;
+
+		struct Subscriber
+		{
+			const Widget * source;
+			Handler handler;
+		};
+		using SubscriberList = SlotList<Subscriber>;
+
+		struct QueuedEvent
+		{
+			WidgetEvent event;
+			bool cancelled;
+		};
+		using EventQueue = std::vector<QueuedEvent>;
+
+		// By class, allocated as classes subscribe.  Lists don't move when a handler
+		// subscribes to a new class.
+		std::vector<std::unique_ptr<SubscriberList>> m_subscribers;
+		std::unordered_map<SubscriptionID, EventClass> m_classes; // Class of each subscription
+		uint32_t m_nextID = 1;
+		int m_dispatching = 0;
+
+		EventQueue m_queue;
+		EventQueue m_delivering;
+
+		bool m_sdlBridge = false;
+		EventBusStats m_stats;
+	};
+
+	constexpr auto EVENTS = &EventBus::Get;
+}
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "stdafx.h"
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "GlyphAtlas.h"
+#include "DrawBatch.h"
+#include "Profiler.h"
+#include "ClipStack.h"
+#include <algorithm>
+
+namespace CoreUI
+{
+	void GlyphAtlas::Init(RendererRef renderer)
+	{
+		Clear();
+		m_renderer = renderer;
+	}
+
+	void GlyphAtlas::Clear()
+	{
+		m_fonts.clear();
+		m_pages.clear();
+		m_batches.clear();
+		m_lastFont = nullptr;
+		m_lastGlyphs = nullptr;
+		m_renderer = nullptr;
+	}
+
+	GlyphAtlas::FontGlyphs & GlyphAtlas::GetFontGlyphs(FontRef font)
+	{
+		if (font != m_lastFont)
+		{
+			auto & glyphs = m_fonts[font];
+			if (!glyphs)
+			{
+				glyphs.reset(new FontGlyphs());
+			}
+			m_lastFont = font;
+			m_lastGlyphs = glyphs.get();
+		}
+		return *m_lastGlyphs;
+	}
+
+	const GlyphAtlas::Glyph & GlyphAtlas::GetGlyph(FontGlyphs & glyphs, FontRef font, uint8_t ch)
+	{
+		Glyph & glyph = glyphs[ch];
+		if (!glyph.loaded)
+		{
+			RenderGlyph(font, ch, glyph);
+		}
+		return glyph;
+	}
+
+	void GlyphAtlas::RenderGlyph(FontRef font, uint8_t ch, Glyph & glyph)
+	{
+		glyph.loaded = true;
+
+		int minX = 0;
+		if (TTF_GlyphMetrics(font, ch, &minX, nullptr, nullptr, nullptr, &glyph.advance) != 0)
+		{
+			return;
+		}
+
+		// Rendered surface starts at the leftmost pixel if the glyph extends before the pen position
+		glyph.offset = std::min(0, minX);
+
+		PROFILE_COUNT(glyphsRendered);
+		SDL_Surface * surface = TTF_RenderGlyph_Blended(font, ch, Color::C_WHITE);
+		if (surface == nullptr)
+		{
+			return; // Nothing to draw, i.e. space
+		}
+
+		if (surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+		{
+			SDL_Surface * converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+			SDL_FreeSurface(surface);
+			surface = converted;
+		}
+
+		if (surface == nullptr || !PackGlyph(surface, glyph))
+		{
+			std::cerr << "GlyphAtlas: Unable to add glyph " << (int)ch << std::endl;
+		}
+
+		SDL_FreeSurface(surface);
+	}
+
+	bool GlyphAtlas::PackGlyph(SDL_Surface * surface, Glyph & glyph)
+	{
+		const int padding = 1;
+		int w = surface->w + padding;
+		int h = surface->h + padding;
+		if (w > m_pageSize || h > m_pageSize || m_renderer == nullptr)
+		{
+			return false;
+		}
+
+		// Shelf packing: glyphs fill rows left to right, new row when full, new page when out of rows
+		Page * page = m_pages.empty() ? nullptr : &m_pages.back();
+		if (page && (page->shelfX + w > m_pageSize))
+		{
+			page->shelfX = 0;
+			page->shelfY += page->shelfHeight;
+			page->shelfHeight = 0;
+		}
+
+		if (page == nullptr || (page->shelfY + h > m_pageSize))
+		{
+			TexturePtr texture = MakeTexture(SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, m_pageSize, m_pageSize));
+			if (!texture)
+			{
+				return false;
+			}
+			SDL_SetTextureBlendMode(texture.get(), SDL_BLENDMODE_BLEND);
+
+			// Unused areas are undefined until written
+			std::vector<Uint32> blank(m_pageSize * m_pageSize, 0);
+			SDL_UpdateTexture(texture.get(), nullptr, blank.data(), m_pageSize * sizeof(Uint32));
+
+			m_pages.emplace_back();
+			m_pages.back().texture = texture;
+			m_batches.resize(m_pages.size());
+			page = &m_pages.back();
+		}
+
+		glyph.source = Rect(page->shelfX, page->shelfY, surface->w, surface->h);
+		if (SDL_UpdateTexture(page->texture.get(), &glyph.source, surface->pixels, surface->pitch) != 0)
+		{
+			return false;
+		}
+
+		glyph.page = (int)m_pages.size() - 1;
+		page->shelfX += w;
+		page->shelfHeight = std::max(page->shelfHeight, h);
+		return true;
+	}
+
+	int GlyphAtlas::GetKerning(FontRef font, uint8_t prev, uint8_t ch)
+	{
+		return prev ? TTF_GetFontKerningSizeGlyphs(font, prev, ch) : 0;
+	}
+
+	Point GlyphAtlas::GetTextSize(FontRef font, const char * text, size_t len)
+	{
+		Point size;
+		if (font == nullptr || text == nullptr || *text == '\0')
+		{
+			return size;
+		}
+
+		FontGlyphs & glyphs = GetFontGlyphs(font);
+		int lineSkip = TTF_FontLineSkip(font);
+
+		int x = 0;
+		uint8_t prev = 0;
+		size.y = TTF_FontHeight(font);
+		for (size_t i = 0; i < len && text[i]; ++i)
+		{
+			uint8_t ch = (uint8_t)text[i];
+			if (ch == '\n')
+			{
+				x = 0;
+				prev = 0;
+				size.y += lineSkip;
+				continue;
+			}
+
+			x += GetKerning(font, prev, ch) + GetGlyph(glyphs, font, ch).advance;
+			size.x = std::max(size.x, x);
+			prev = ch;
+		}
+
+		return size;
+	}
+
+	int GlyphAtlas::GetTextWidth(FontRef font, const char * text, size_t len)
+	{
+		if (font == nullptr || text == nullptr)
+		{
+			return 0;
+		}
+
+		FontGlyphs & glyphs = GetFontGlyphs(font);
+
+		int x = 0;
+		uint8_t prev = 0;
+		for (size_t i = 0; i < len && text[i] && text[i] != '\n'; ++i)
+		{
+			uint8_t ch = (uint8_t)text[i];
+			x += GetKerning(font, prev, ch) + GetGlyph(glyphs, font, ch).advance;
+			prev = ch;
+		}
+
+		return x;
+	}
+
+	void GlyphAtlas::GetTextPositions(FontRef font, const char * text, std::vector<int> & positions, size_t len)
+	{
+		positions.assign(1, 0);
+		if (font == nullptr || text == nullptr)
+		{
+			return;
+		}
+
+		FontGlyphs & glyphs = GetFontGlyphs(font);
+
+		int x = 0;
+		uint8_t prev = 0;
+		for (size_t i = 0; i < len && text[i] && text[i] != '\n'; ++i)
+		{
+			uint8_t ch = (uint8_t)text[i];
+			x += GetKerning(font, prev, ch) + GetGlyph(glyphs, font, ch).advance;
+			positions.push_back(x);
+			prev = ch;
+		}
+	}
+
+	void GlyphAtlas::DrawText(FontRef font, const char * text, const PointRef pos, const Color & color, const RectRef clip)
+	{
+		if (font == nullptr || text == nullptr || pos == nullptr || CLIP().IsEmpty())
+		{
+			return;
+		}
+
+		FontGlyphs & glyphs = GetFontGlyphs(font);
+		int lineSkip = TTF_FontLineSkip(font);
+
+		Point pen = *pos;
+		uint8_t prev = 0;
+		for (const char * c = text; *c; ++c)
+		{
+			uint8_t ch = (uint8_t)*c;
+			if (ch == '\n')
+			{
+				pen.x = pos->x;
+				pen.y += lineSkip;
+				prev = 0;
+				continue;
+			}
+
+			pen.x += GetKerning(font, prev, ch);
+			prev = ch;
+
+			const Glyph & glyph = GetGlyph(glyphs, font, ch);
+			if (glyph.page != -1)
+			{
+				Rect dest(pen.x + glyph.offset, pen.y, glyph.source.w, glyph.source.h);
+				if (!CLIP().IsVisible(dest))
+				{
+					pen.x += glyph.advance;
+					continue;
+				}
+
+				Rect source = glyph.source;
+				if (clip)
+				{
+					Rect visible = dest.IntersectRect(clip);
+					if (visible.IsEmpty())
+					{
+						pen.x += glyph.advance;
+						continue;
+					}
+					source.x += visible.x - dest.x;
+					source.y += visible.y - dest.y;
+					source.w = visible.w;
+					source.h = visible.h;
+					dest = visible;
+				}
+				AddQuad(glyph.page, dest, source, color);
+			}
+			pen.x += glyph.advance;
+		}
+
+		Flush();
+	}
+
+	void GlyphAtlas::AddQuad(int page, const Rect & dest, const Rect & source, const Color & color)
+	{
+		const float scale = 1.0f / m_pageSize;
+		const Point & origin = CLIP().GetOrigin();
+		const float x1 = (float)(dest.x - origin.x);
+		const float y1 = (float)(dest.y - origin.y);
+		const float x2 = (float)(dest.x + dest.w - origin.x);
+		const float y2 = (float)(dest.y + dest.h - origin.y);
+		const float u1 = source.x * scale;
+		const float v1 = source.y * scale;
+		const float u2 = (source.x + source.w) * scale;
+		const float v2 = (source.y + source.h) * scale;
+
+		Batch & batch = m_batches[page];
+		int base = (int)batch.vertices.size();
+		batch.vertices.push_back({ { x1, y1 }, color, { u1, v1 } });
+		batch.vertices.push_back({ { x2, y1 }, color, { u2, v1 } });
+		batch.vertices.push_back({ { x2, y2 }, color, { u2, v2 } });
+		batch.vertices.push_back({ { x1, y2 }, color, { u1, v2 } });
+
+		for (int i : { 0, 1, 2, 0, 2, 3 })
+		{
+			batch.indices.push_back(base + i);
+		}
+	}
+
+	void GlyphAtlas::Flush()
+	{
+		// Keep ordering with primitives queued before the text
+		BATCH().Flush();
+
+		for (size_t i = 0; i < m_batches.size(); ++i)
+		{
+			Batch & batch = m_batches[i];
+			if (!batch.indices.empty())
+			{
+				PROFILE_COUNT(geometryCalls);
+				SDL_RenderGeometry(m_renderer, m_pages[i].texture.get(),
+					batch.vertices.data(), (int)batch.vertices.size(),
+					batch.indices.data(), (int)batch.indices.size());
+
+				batch.vertices.clear();
+				batch.indices.clear();
+			}
+		}
+	}
+}
\ No newline at end of file
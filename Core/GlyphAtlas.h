@@ -0,0 +1,89 @@
+#pragma once
+#include "Common.h"
+#include "Color.h"
+#include "Point.h"
+#include "Rect.h"
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace CoreUI
+{
+	// Shared text renderer.  Glyphs of all fonts are rasterized once in white and packed
+	// in a few large textures, text is drawn as batches of quads tinted with the text color.
+	// Text is Latin-1 (same as TTF_RenderText), '\n' starts a new line.
+	class DllExport GlyphAtlas
+	{
+	public:
+		GlyphAtlas() = default;
+		virtual ~GlyphAtlas() = default;
+		GlyphAtlas(const GlyphAtlas&) = delete;
+		GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+		GlyphAtlas(GlyphAtlas&&) = delete;
+		GlyphAtlas& operator=(GlyphAtlas&&) = delete;
+
+		void Init(RendererRef renderer);
+		void Clear();
+
+		Point GetTextSize(FontRef font, const char * text, size_t len = std::string::npos);
+		int GetTextWidth(FontRef font, const char * text, size_t len = std::string::npos); // Width of first line
+
+		// Pen position before each character of the first line and after the last one
+		void GetTextPositions(FontRef font, const char * text, std::vector<int> & positions, size_t len = std::string::npos);
+
+		// Draws text with its top left corner at 'pos', cut to 'clip' if provided
+		void DrawText(FontRef font, const char * text, const PointRef pos, const Color & color, const RectRef clip = nullptr);
+
+		size_t GetPageCount() const { return m_pages.size(); }
+
+	protected:
+		struct Glyph
+		{
+			bool loaded = false;
+			int page = -1; // -1: nothing to draw (e.g. space)
+			Rect source;
+			int offset = 0; // Horizontal offset from pen position
+			int advance = 0;
+		};
+		using FontGlyphs = std::array<Glyph, 256>;
+		using FontMap = std::map<FontRef, std::unique_ptr<FontGlyphs>>;
+
+		struct Page
+		{
+			TexturePtr texture;
+			int shelfX = 0;
+			int shelfY = 0;
+			int shelfHeight = 0;
+		};
+		using PageList = std::vector<Page>;
+
+		// Quads waiting to be drawn, one batch per page.  Kept between calls to avoid allocations
+		struct Batch
+		{
+			std::vector<SDL_Vertex> vertices;
+			std::vector<int> indices;
+		};
+		using BatchList = std::vector<Batch>;
+
+		FontGlyphs & GetFontGlyphs(FontRef font);
+		const Glyph & GetGlyph(FontGlyphs & glyphs, FontRef font, uint8_t ch);
+		void RenderGlyph(FontRef font, uint8_t ch, Glyph & glyph);
+		bool PackGlyph(SDL_Surface * surface, Glyph & glyph);
+		int GetKerning(FontRef font, uint8_t prev, uint8_t ch);
+
+		void AddQuad(int page, const Rect & dest, const Rect & source, const Color & color);
+		void Flush();
+
+		static constexpr int m_pageSize = 512;
+
+		RendererRef m_renderer = nullptr;
+		FontMap m_fonts;
+		PageList m_pages;
+		BatchList m_batches;
+
+		// Last font looked up, text is usually drawn with the same font many times in a row
+		FontRef m_lastFont = nullptr;
+		FontGlyphs * m_lastGlyphs = nullptr;
+	};
+}
\ No newline at end of file
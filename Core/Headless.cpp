@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "Headless.h"
+#include "ResourceManager.h"
+#include "WindowManager.h"
+#include "DrawBatch.h"
+
+namespace CoreUI
+{
+	Headless::Headless(int width, int height) : m_size(0, 0, width, height)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			throw std::invalid_argument("invalid size");
+		}
+
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+		SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+		m_sdlInit = (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS) == 0);
+		m_ttfInit = m_sdlInit && (TTF_Init() == 0);
+		if (m_ttfInit)
+		{
+			m_window = MainWindowPtr(SDL_CreateWindow("CoreUI", 0, 0, width, height, SDL_WINDOW_HIDDEN));
+		}
+		if (m_window)
+		{
+			m_renderer = RendererPtr(SDL_CreateRenderer(m_window.get(), -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE));
+		}
+		if (m_renderer)
+		{
+			m_target = MakeTexture(SDL_CreateTexture(m_renderer.get(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height));
+		}
+
+		if (!m_target || SDL_SetRenderTarget(m_renderer.get(), m_target.get()) != 0)
+		{
+			std::string error = SDL_GetError();
+			Dispose();
+			throw std::runtime_error("Unable to start headless mode: " + error);
+		}
+
+		RES().Init(m_renderer.get());
+		WINMGR().Init(m_window.get(), m_renderer.get());
+	}
+
+	Headless::~Headless()
+	{
+		Dispose();
+	}
+
+	void Headless::Flush()
+	{
+		BATCH().Flush();
+		SDL_RenderFlush(m_renderer.get());
+	}
+
+	void Headless::Dispose()
+	{
+		if (m_renderer)
+		{
+			WINMGR().Dispose();
+			RES().Dispose();
+		}
+
+		m_target = nullptr;
+		m_renderer = nullptr;
+		m_window = nullptr;
+
+		if (m_ttfInit)
+		{
+			TTF_Quit();
+			m_ttfInit = false;
+		}
+		if (m_sdlInit)
+		{
+			SDL_Quit();
+			m_sdlInit = false;
+		}
+	}
+}
\ No newline at end of file
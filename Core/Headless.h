@@ -0,0 +1,40 @@
+#pragma once
+#include "Common.h"
+#include "Rect.h"
+
+namespace CoreUI
+{
+	// Runs the library without a display: SDL's dummy video driver, a hidden window and
+	// the software renderer drawing into an offscreen texture.  Initializes SDL, SDL_ttf,
+	// the resource manager and the window manager, and shuts them down when destroyed.
+	//
+	// Must be created before anything else initializes SDL video.
+	class DllExport Headless
+	{
+	public:
+		Headless(int width, int height);
+		virtual ~Headless();
+		Headless(const Headless&) = delete;
+		Headless& operator=(const Headless&) = delete;
+		Headless(Headless&&) = delete;
+		Headless& operator=(Headless&&) = delete;
+
+		MainWindowRef GetWindow() const { return m_window.get(); }
+		RendererRef GetRenderer() const { return m_renderer.get(); }
+		TextureRef GetTarget() const { return m_target.get(); }
+		Rect GetSize() const { return m_size; }
+
+		// Waits for queued rendering to complete, for timing
+		void Flush();
+
+	protected:
+		void Dispose();
+
+		Rect m_size;
+		MainWindowPtr m_window;
+		RendererPtr m_renderer;
+		TexturePtr m_target;
+		bool m_sdlInit = false;
+		bool m_ttfInit = false;
+	};
+}
\ No newline at end of file
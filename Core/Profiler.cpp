@@ -0,0 +1,125 @@
+#include "stdafx.h"
+#include "Profiler.h"
+#include "Widget.h"
+#include "Window.h"
+#include "WindowManager.h"
+#include "Widgets/TextBox.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace CoreUI
+{
+	static const char * s_categoryNames[] = { "Draw", "HitTest", "Controls", "Event" };
+	static const char * s_overlayId = "coreUI.profiler";
+	static const size_t s_overlayScopes = 8;
+
+	Profiler & Profiler::Get()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	size_t Profiler::OpenScope(ProfileCategory category, const Widget * widget)
+	{
+		ScopeKey key = { category, widget };
+		auto it = m_scopeIndex.find(key);
+		if (it == m_scopeIndex.end())
+		{
+			// Name is only built the first time the scope is seen in a frame
+			ScopeStats scope;
+			std::string path;
+			for (WidgetRef w = (WidgetRef)widget; w; w = w->GetParent())
+			{
+				path = path.empty() ? w->GetId() : (w->GetId() + "/" + path);
+			}
+			scope.name = s_categoryNames[category];
+			if (!path.empty())
+			{
+				scope.name += ' ' + path;
+			}
+
+			it = m_scopeIndex.emplace(key, m_current.scopes.size()).first;
+			m_current.scopes.push_back(std::move(scope));
+		}
+		return it->second;
+	}
+
+	void Profiler::CloseScope(size_t scope, uint64_t frame, double ms)
+	{
+		// Opened before the frame ended, the index is stale
+		if (frame != m_last.frame)
+			return;
+
+		ScopeStats & stats = m_current.scopes[scope];
+		stats.ms += ms;
+		++stats.calls;
+	}
+
+	void Profiler::EndFrame(double frameMs)
+	{
+		std::sort(m_current.scopes.begin(), m_current.scopes.end(),
+			[](const ScopeStats & a, const ScopeStats & b) { return a.ms > b.ms; });
+
+		m_current.frame = m_last.frame + 1;
+		m_current.frameMs = frameMs;
+		m_last = std::move(m_current);
+
+		m_current = FrameStats();
+		m_scopeIndex.clear();
+	}
+
+	void Profiler::ShowOverlay(bool show)
+	{
+		if (show == IsOverlayShown())
+			return;
+
+		if (show)
+		{
+			m_overlay = WINMGR().AddWindow(s_overlayId, Rect(0, 0, 420, 260), WIN_CANMOVE | WIN_CANRESIZE | WIN_NOACTIVE);
+			m_overlay->SetText("Profiler");
+			m_overlayText = TextBox::CreateFill("stats", WINMGR().GetRenderer(), "");
+			m_overlay->AddControl(m_overlayText);
+			UpdateOverlay();
+		}
+		else
+		{
+			m_overlayText = nullptr;
+			m_overlay = nullptr;
+			m_overlayString.clear();
+			WINMGR().RemoveWindow(s_overlayId);
+		}
+	}
+
+	void Profiler::UpdateOverlay()
+	{
+		if (!m_overlayText)
+			return;
+
+		const FrameStats & s = m_last;
+		char buf[256];
+		std::string text;
+
+		snprintf(buf, sizeof(buf), "Frame %llu: %.3f ms\n", (unsigned long long)s.frame, s.frameMs);
+		text += buf;
+		snprintf(buf, sizeof(buf), "RenderCopy %u, geometry %u, primitives %u\n", s.renderCopies, s.geometryCalls, s.primitiveCalls);
+		text += buf;
+		snprintf(buf, sizeof(buf), "Draw color %u, clip rect %u\n", s.drawColorChanges, s.clipRectChanges);
+		text += buf;
+		snprintf(buf, sizeof(buf), "Textures %u, glyphs %u\n", s.texturesCreated, s.glyphsRendered);
+		text += buf;
+
+		for (size_t i = 0; i < s.scopes.size() && i < s_overlayScopes; ++i)
+		{
+			const ScopeStats & scope = s.scopes[i];
+			snprintf(buf, sizeof(buf), "%8.3f ms %5u  %s\n", scope.ms, scope.calls, scope.name.c_str());
+			text += buf;
+		}
+
+		// Unchanged text would invalidate the overlay, and keep an idle host drawing
+		if (text != m_overlayString)
+		{
+			m_overlayString = std::move(text);
+			m_overlayText->SetText(m_overlayString.c_str());
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include "Common.h"
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CoreUI
+{
+	class Widget;
+
+	enum ProfileCategory
+	{
+		PROFILE_DRAW,
+		PROFILE_HITTEST,
+		PROFILE_CONTROLS,
+		PROFILE_EVENT,
+	};
+
+	// Time spent in one instrumented scope (i.e. "Draw" of a given widget) during a frame.
+	// Nested scopes are included in their parent's time.
+	struct DllExport ScopeStats
+	{
+		std::string name;
+		double ms = 0;
+		uint32_t calls = 0;
+	};
+
+	struct DllExport FrameStats
+	{
+		uint64_t frame = 0;
+		double frameMs = 0; // WindowManager::Draw
+
+		// SDL calls
+		uint32_t renderCopies = 0; // SDL_RenderCopy
+		uint32_t geometryCalls = 0; // SDL_RenderGeometry (text)
+		uint32_t primitiveCalls = 0; // Rectangles, lines and points
+		uint32_t drawColorChanges = 0;
+		uint32_t clipRectChanges = 0;
+		uint32_t texturesCreated = 0;
+		uint32_t glyphsRendered = 0; // TTF rasterizations
+
+		std::vector<ScopeStats> scopes; // Slowest first
+	};
+
+	// Frame instrumentation.  Scopes and counters are only compiled in when the library
+	// is built with COREUI_PROFILE, otherwise the stats stay empty.
+	//
+	// Everything recorded between two WindowManager::Draw() calls goes to the frame
+	// completed by the second one, including event handling and hit tests.
+	class DllExport Profiler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		virtual ~Profiler() = default;
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler(Profiler&&) = delete;
+		Profiler& operator=(Profiler&&) = delete;
+
+		static Profiler & Get();
+
+		static constexpr bool IsEnabled()
+		{
+#ifdef COREUI_PROFILE
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		FrameStats & GetCurrentFrame() { return m_current; }
+		const FrameStats & GetLastFrame() const { return m_last; }
+
+		// A scope is named when opened, while its widget is known to be alive: a handler
+		// may destroy it before the scope closes.  Returns the scope's index in the frame.
+		size_t OpenScope(ProfileCategory category, const Widget * widget);
+		void CloseScope(size_t scope, uint64_t frame, double ms); // 'frame': last frame when opened
+		void EndFrame(double frameMs);
+
+		// Small window listing the previous frame's stats, refreshed when a frame is drawn
+		void ShowOverlay(bool show);
+		bool IsOverlayShown() const { return m_overlay != nullptr; }
+		void UpdateOverlay();
+
+	protected:
+		Profiler() = default;
+
+		struct ScopeKey
+		{
+			ProfileCategory category;
+			const Widget * widget;
+			bool operator==(const ScopeKey & rhs) const { return category == rhs.category && widget == rhs.widget; }
+		};
+		struct ScopeKeyHash
+		{
+			size_t operator()(const ScopeKey & key) const { return std::hash<const void*>()(key.widget) ^ key.category; }
+		};
+		using ScopeIndex = std::unordered_map<ScopeKey, size_t, ScopeKeyHash>;
+
+		FrameStats m_current;
+		FrameStats m_last;
+		ScopeIndex m_scopeIndex; // Position in m_current.scopes
+
+		WindowPtr m_overlay;
+		TextBoxPtr m_overlayText;
+		std::string m_overlayString; // Shown in m_overlayText
+	};
+
+	constexpr auto PROFILER = &Profiler::Get;
+
+	class ProfileScope
+	{
+	public:
+		ProfileScope(ProfileCategory category, const Widget * widget) :
+			m_scope(PROFILER().OpenScope(category, widget)), m_frame(PROFILER().GetLastFrame().frame),
+			m_start(Profiler::Clock::now())
+		{
+		}
+
+		~ProfileScope()
+		{
+			std::chrono::duration<double, std::milli> elapsed = Profiler::Clock::now() - m_start;
+			PROFILER().CloseScope(m_scope, m_frame, elapsed.count());
+		}
+
+	private:
+		size_t m_scope;
+		uint64_t m_frame;
+		Profiler::Clock::time_point m_start; // After the scope is named, not timed
+	};
+}
+
+#ifdef COREUI_PROFILE
+#define PROFILE_SCOPE(category, widget) CoreUI::ProfileScope profileScope_(category, widget)
+#define PROFILE_COUNT(counter) ++CoreUI::PROFILER().GetCurrentFrame().counter
+#else
+#define PROFILE_SCOPE(category, widget)
+#define PROFILE_COUNT(counter)
+#endif
\ No newline at end of file
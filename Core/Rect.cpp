@@ -22,6 +22,18 @@ namespace CoreUI
 		return ret;
 	}
 
+	Rect Rect::UnionRect(const RectRef otherRect)
+	{
+		Rect ret;
+		SDL_UnionRect(this, otherRect, &ret);
+		return ret;
+	}
+
+	bool Rect::HasIntersection(const RectRef otherRect) const
+	{
+		return SDL_HasIntersection(this, otherRect);
+	}
+
 	bool Rect::PointInRect(const PointRef pt, const RectRef rect)
 	{
 		return SDL_PointInRect(pt, rect);
@@ -27,6 +27,8 @@ namespace CoreUI
 		}
 
 		Dimension operator+(const Dimension& rhs) const { return Dimension(w + rhs.w, h + rhs.h); }
+		bool operator==(const Dimension& rhs) const { return w == rhs.w && h == rhs.h; }
+		bool operator!=(const Dimension& rhs) const { return !(*this == rhs); }
 
 		explicit operator bool() const { return w || h; }
 
@@ -51,6 +53,8 @@ namespace CoreUI
 
 		bool PointInRect(const PointRef pt) { return SDL_PointInRect(pt, this); }
 		Rect IntersectRect(const RectRef);
+		Rect UnionRect(const RectRef);
+		bool HasIntersection(const RectRef) const;
 
 		Point Origin() const { return Point(x, y); }
 		Point Size() const { return Point(w, h); }
@@ -19,12 +19,14 @@ namespace CoreUI
 	void ResourceManager::Init(RendererRef renderer)
 	{
 		m_renderer = renderer;
+		m_glyphAtlas.Init(renderer);
 
 		LoadInternalResources();
 	}
 
 	void ResourceManager::Dispose()
 	{
+		m_glyphAtlas.Clear();
 		m_fonts.clear();
 		m_images.clear();
 		m_cursors.clear();
@@ -1,6 +1,7 @@
 #pragma once
 #include "Common.h"
 #include "Color.h"
+#include "GlyphAtlas.h"
 #include <string>
 #include <map>
 
@@ -42,6 +43,9 @@ namespace CoreUI
 		CursorRef LoadCursor(const char * id, SDL_SystemCursor);
 		CursorRef FindCursor(const char * id);
 
+		// Text
+		GlyphAtlas & GetGlyphAtlas() { return m_glyphAtlas; }
+
 	protected:
 		FontRef LoadFont(ResourceMap::ResourceInfo & res);
 		ImageMapRef LoadImageMap(ResourceMap::ResourceInfo & res);
@@ -55,6 +59,7 @@ namespace CoreUI
 		FontList m_fonts;
 		ImageList m_images;
 		CursorList m_cursors;
+		GlyphAtlas m_glyphAtlas;
 	};
 
 	constexpr auto RES = &ResourceManager::Get;
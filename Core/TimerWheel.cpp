@@ -0,0 +1,271 @@
+#include "stdafx.h"
+#include "TimerWheel.h"
+#include <algorithm>
+
+namespace CoreUI
+{
+	TimerWheel::TimerWheel()
+	{
+		Clear();
+	}
+
+	void TimerWheel::Clear()
+	{
+		m_entries.clear();
+		m_free.clear();
+		m_ids.clear();
+		for (auto & level : m_slots)
+		{
+			std::fill(std::begin(level), std::end(level), (int)m_none);
+		}
+		m_time = 0;
+		m_ticks = 0;
+		m_started = false;
+	}
+
+	void TimerWheel::Add(const Timer & timer, Uint32 interval, Uint32 now)
+	{
+		if (m_ids.find(timer.GetID()) != m_ids.end())
+		{
+			throw std::invalid_argument("timer already exists");
+		}
+
+		if (!m_started)
+		{
+			m_ticks = now;
+			m_started = true;
+		}
+
+		int index;
+		if (m_free.empty())
+		{
+			index = (int)m_entries.size();
+			m_entries.emplace_back();
+		}
+		else
+		{
+			index = m_free.back();
+			m_free.pop_back();
+		}
+
+		Entry & entry = m_entries[index];
+		entry = Entry();
+		entry.timer = timer;
+		entry.interval = std::max(interval, (Uint32)1);
+		entry.expiry = GetTime(now) + entry.interval;
+		m_ids[timer.GetID()] = index;
+		Schedule(index);
+	}
+
+	bool TimerWheel::Remove(Uint32 id)
+	{
+		auto it = m_ids.find(id);
+		if (it == m_ids.end())
+		{
+			return false;
+		}
+
+		Unlink(it->second);
+		m_free.push_back(it->second);
+		m_ids.erase(it);
+		return true;
+	}
+
+	void TimerWheel::RemoveOwned(const Widget * owner)
+	{
+		for (auto it = m_ids.begin(); it != m_ids.end(); )
+		{
+			if (m_entries[it->second].timer.GetWidget() == owner)
+			{
+				Unlink(it->second);
+				m_free.push_back(it->second);
+				it = m_ids.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	bool TimerWheel::Reschedule(Uint32 id, Uint32 interval, Uint32 now)
+	{
+		auto it = m_ids.find(id);
+		if (it == m_ids.end())
+		{
+			return false;
+		}
+
+		Entry & entry = m_entries[it->second];
+		Unlink(it->second);
+		entry.interval = std::max(interval, (Uint32)1);
+		entry.expiry = GetTime(now) + entry.interval;
+		Schedule(it->second);
+		return true;
+	}
+
+	const Timer * TimerWheel::Find(Uint32 id) const
+	{
+		auto it = m_ids.find(id);
+		return (it != m_ids.end()) ? &m_entries[it->second].timer : nullptr;
+	}
+
+	void TimerWheel::Advance(Uint32 now, std::vector<Uint32> & expired)
+	{
+		if (!m_started)
+			return;
+
+		uint64_t target = GetTime(now);
+		m_ticks = now;
+
+		while (m_time < target)
+		{
+			if (m_ids.empty())
+			{
+				m_time = target;
+				break;
+			}
+
+			++m_time;
+
+			// Entering a new block of a level: move its timers down, highest level first
+			int level = 0;
+			while (level < m_levels - 1 && ((m_time >> (m_slotBits * level)) & (m_slotCount - 1)) == 0)
+			{
+				++level;
+			}
+			for (; level > 0; --level)
+			{
+				Cascade(level);
+			}
+
+			int & head = m_slots[0][m_time & (m_slotCount - 1)];
+			while (head != m_none)
+			{
+				int index = head;
+				Entry & entry = m_entries[index];
+				Unlink(index);
+				expired.push_back(entry.timer.GetID());
+
+				if (!entry.timer.IsOneShot())
+				{
+					// Next expiry after 'target', skipped intervals are coalesced
+					uint64_t missed = (target - entry.expiry) / entry.interval;
+					entry.expiry += (missed + 1) * entry.interval;
+					Schedule(index);
+				}
+			}
+		}
+	}
+
+	bool TimerWheel::GetNextExpiry(Uint32 & ticks) const
+	{
+		// In a level, slots following the current one hold later and later blocks of
+		// time: the earliest timer is in the first non-empty slot.  Lower levels aren't
+		// always earlier, timers of a higher level may be about to cascade.
+		const uint64_t farthest = m_time + ((uint64_t)1 << (m_slotBits * m_levels)) - 1;
+		uint64_t next = 0;
+		bool found = false;
+
+		for (int level = 0; level < m_levels; ++level)
+		{
+			int current = (int)((m_time >> (m_slotBits * level)) & (m_slotCount - 1));
+			for (int i = 1; i <= m_slotCount; ++i)
+			{
+				int index = m_slots[level][(current + i) & (m_slotCount - 1)];
+				if (index == m_none)
+					continue;
+
+				for (; index != m_none; index = m_entries[index].next)
+				{
+					// Beyond the wheel's range, waking up at the parking slot is early enough
+					uint64_t expiry = std::min(m_entries[index].expiry, farthest);
+					if (!found || expiry < next)
+					{
+						next = expiry;
+						found = true;
+					}
+				}
+				break;
+			}
+		}
+
+		if (found)
+		{
+			ticks = m_ticks + (Uint32)(next - m_time);
+		}
+		return found;
+	}
+
+	void TimerWheel::Schedule(int index)
+	{
+		Entry & entry = m_entries[index];
+		// Only timers cascaded down can be due now, they land in the slot processed next
+		uint64_t expiry = std::max(entry.expiry, m_time);
+		uint64_t delta = expiry - m_time;
+
+		int level = 0;
+		while (level < m_levels - 1 && delta >= ((uint64_t)1 << (m_slotBits * (level + 1))))
+		{
+			++level;
+		}
+
+		// Beyond the top level: parked in the farthest slot and moved again when cascaded
+		if (delta >= ((uint64_t)1 << (m_slotBits * m_levels)))
+		{
+			expiry = m_time + ((uint64_t)1 << (m_slotBits * m_levels)) - 1;
+		}
+
+		int slot = (int)((expiry >> (m_slotBits * level)) & (m_slotCount - 1));
+		int & head = m_slots[level][slot];
+
+		entry.slot = level * m_slotCount + slot;
+		entry.prev = m_none;
+		entry.next = head;
+		if (head != m_none)
+		{
+			m_entries[head].prev = index;
+		}
+		head = index;
+	}
+
+	void TimerWheel::Unlink(int index)
+	{
+		Entry & entry = m_entries[index];
+		if (entry.slot == m_none)
+			return;
+
+		if (entry.prev != m_none)
+		{
+			m_entries[entry.prev].next = entry.next;
+		}
+		else
+		{
+			m_slots[entry.slot / m_slotCount][entry.slot % m_slotCount] = entry.next;
+		}
+
+		if (entry.next != m_none)
+		{
+			m_entries[entry.next].prev = entry.prev;
+		}
+
+		entry.slot = m_none;
+		entry.prev = m_none;
+		entry.next = m_none;
+	}
+
+	void TimerWheel::Cascade(int level)
+	{
+		int & head = m_slots[level][(m_time >> (m_slotBits * level)) & (m_slotCount - 1)];
+		int index = head;
+		head = m_none;
+
+		while (index != m_none)
+		{
+			int next = m_entries[index].next;
+			m_entries[index].slot = m_none;
+			Schedule(index);
+			index = next;
+		}
+	}
+}
\ No newline at end of file
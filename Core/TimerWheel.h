@@ -0,0 +1,73 @@
+#pragma once
+#include "Common.h"
+#include "Widget.h"
+#include "Timer.h"
+#include <unordered_map>
+#include <vector>
+
+namespace CoreUI
+{
+	// Hierarchical timing wheel with 1 ms resolution.  Timers are kept in slots by
+	// expiry time, finer slots for nearer expirations, and moved down a level as
+	// their time approaches.  Adding, removing and rescheduling a timer is O(1),
+	// advancing only looks at the slots passed.
+	//
+	// Times are SDL_GetTicks() values, wrap around is handled.
+	class DllExport TimerWheel
+	{
+	public:
+		TimerWheel();
+
+		void Clear();
+
+		// Repeating timers fire every 'interval' ms, one shot timers once after 'interval' ms
+		void Add(const Timer & timer, Uint32 interval, Uint32 now);
+		bool Remove(Uint32 id);
+		void RemoveOwned(const Widget * owner);
+		// Restarts the timer, next expiry is 'interval' ms from 'now'
+		bool Reschedule(Uint32 id, Uint32 interval, Uint32 now);
+
+		const Timer * Find(Uint32 id) const;
+		size_t GetCount() const { return m_ids.size(); }
+
+		// Appends the ids of the timers expired at 'now', in expiry order.  A repeating
+		// timer is reported once even if several intervals went by.  One shot timers stay
+		// until removed, so the caller can tell whether they were cancelled meanwhile.
+		void Advance(Uint32 now, std::vector<Uint32> & expired);
+
+		// Ticks at which Advance() will next report a timer, false if none is scheduled.
+		// Looks at one slot per level.
+		bool GetNextExpiry(Uint32 & ticks) const;
+
+	protected:
+		static const int m_slotBits = 6;
+		static const int m_slotCount = 1 << m_slotBits;
+		static const int m_levels = 4;
+		static const int m_none = -1;
+
+		struct Entry
+		{
+			Timer timer;
+			Uint32 interval = 0;
+			uint64_t expiry = 0;
+			int slot = m_none; // Level * m_slotCount + index, m_none if not scheduled
+			int prev = m_none;
+			int next = m_none;
+		};
+
+		uint64_t GetTime(Uint32 now) const { return m_time + (Uint32)(now - m_ticks); }
+
+		void Schedule(int index);
+		void Unlink(int index);
+		void Cascade(int level);
+
+		std::vector<Entry> m_entries;
+		std::vector<int> m_free;
+		std::unordered_map<Uint32, int> m_ids; // Position in m_entries
+		int m_slots[m_levels][m_slotCount];
+
+		uint64_t m_time = 0; // Last time advanced to
+		Uint32 m_ticks = 0; // SDL ticks at m_time
+		bool m_started = false;
+	};
+}
\ No newline at end of file
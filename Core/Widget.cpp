@@ -4,11 +4,28 @@
 #include "Rect.h"
 #include "Widget.h"
 #include "WindowManager.h"
+#include "DrawBatch.h"
+#include "EventBus.h"
+#include "ClipStack.h"
+#include "Profiler.h"
 #include "Tooltip.h"
+#include "Util/RenderTarget.h"
 #include "Widgets/Image.h"
 
 namespace CoreUI
 {
+	Widget::~Widget()
+	{
+		if (m_ownsTimers)
+		{
+			WINMGR().DeleteTimers(this);
+		}
+		if (m_postedEvents)
+		{
+			EVENTS().Cancel(this);
+		}
+	}
+
 	Widget::Widget(const char* id) :
 		m_id(id ? id : ""), m_eventClassId(Uint32(-1))
 	{
@@ -57,6 +74,7 @@ namespace CoreUI
 		if (parent == nullptr)
 		{
 			m_focused = true;
+			Invalidate();
 		}
 
 		if (m_parent)
@@ -68,7 +86,40 @@ namespace CoreUI
 
 	void Widget::ClearFocus()
 	{
-		m_focused = false;
+		if (m_focused)
+		{
+			m_focused = false;
+			Invalidate();
+		}
+	}
+
+	void Widget::Invalidate()
+	{
+		// Not attached yet, nothing on screen
+		if (m_parent == nullptr)
+			return;
+
+		m_parent->ChildInvalidated();
+
+		Rect rect = (m_flags & WIN_FILL) ? m_parent->GetClientRect(false, false) : GetRect(false, true);
+		WINMGR().Invalidate(&rect);
+	}
+
+	void Widget::InvalidateGeometry()
+	{
+		if (m_parent)
+		{
+			m_parent->ChildGeometryChanged(this);
+		}
+		Invalidate();
+	}
+
+	void Widget::ChildInvalidated()
+	{
+		if (m_parent)
+		{
+			m_parent->ChildInvalidated();
+		}
 	}
 
 	void Widget::SetFont(FontRef font)
@@ -89,52 +140,63 @@ namespace CoreUI
 
 	void Widget::SetDrawColor(const CoreUI::Color & col)
 	{
+		PROFILE_COUNT(drawColorChanges);
 		SDL_SetRenderDrawColor(m_renderer, col.r, col.g, col.b, col.a);
 	}
 
 	void Widget::Draw3dFrame(const RectRef pos, bool raised, const CoreUI::Color & col)
 	{
-		// Relief effect
-		Point points[5] = { { pos->x, pos->y + pos->h - 1 },{ pos->x + pos->w - 1, pos->y + pos->h - 1 },
-		{ pos->x + pos->w - 1, pos->y },{ pos->x, pos->y },{ pos->x, pos->y + pos->h - 2 } };
+		if (pos->w <= 0 || pos->h <= 0)
+			return;
+
+		// Relief effect: bottom & right edges, then top & left edges
+		const Color & shadow = raised ? col.Darken() : Color::C_WHITE;
+		const Color & light = raised ? Color::C_WHITE : col.Darken();
 
-		SetDrawColor(raised ? col.Darken() : Color::C_WHITE);
-		SDL_RenderDrawLines(m_renderer, points + 0, 3);
+		DrawBatch & batch = BATCH();
+		batch.FillRect(m_renderer, Rect(pos->x, pos->y + pos->h - 1, pos->w, 1), shadow);
+		batch.FillRect(m_renderer, Rect(pos->x + pos->w - 1, pos->y, 1, pos->h), shadow);
 
-		SetDrawColor(raised ? Color::C_WHITE : col.Darken());
-		SDL_RenderDrawLines(m_renderer, points + 2, 3);
+		batch.FillRect(m_renderer, Rect(pos->x, pos->y, pos->w, 1), light);
+		batch.FillRect(m_renderer, Rect(pos->x, pos->y, 1, pos->h - 1), light);
 	}
 
 	void Widget::DrawRect(const RectRef pos, const CoreUI::Color & col, int borderWidth)
 	{
-		SetDrawColor(col);
-
-		SDL_RenderDrawRect(m_renderer, pos);
-
-		if (borderWidth > 1)
+		// A border of 'borderWidth' nested outlines is four bands
+		int width = std::max(1, borderWidth);
+		if (2 * width >= std::min(pos->w, pos->h))
 		{
-			Rect innerRect = *pos;
-			for (int i = 1; i < borderWidth; ++i)
-			{
-				innerRect = innerRect.Deflate(1);
-				SDL_RenderDrawRect(m_renderer, &innerRect);
-			}
+			DrawFilledRect(pos, col);
+			return;
 		}
+
+		DrawBatch & batch = BATCH();
+		batch.FillRect(m_renderer, Rect(pos->x, pos->y, pos->w, width), col);
+		batch.FillRect(m_renderer, Rect(pos->x, pos->y + pos->h - width, pos->w, width), col);
+		batch.FillRect(m_renderer, Rect(pos->x, pos->y + width, width, pos->h - (2 * width)), col);
+		batch.FillRect(m_renderer, Rect(pos->x + pos->w - width, pos->y + width, width, pos->h - (2 * width)), col);
 	}
 
 	void Widget::DrawFilledRect(const RectRef pos, const CoreUI::Color & col)
 	{
-		SetDrawColor(col);
+		BATCH().FillRect(m_renderer, *pos, col);
+	}
+
+	void Widget::DrawLine(int x1, int y1, int x2, int y2, const CoreUI::Color & col)
+	{
+		BATCH().DrawLine(m_renderer, x1, y1, x2, y2, col);
+	}
 
-		SDL_RenderFillRect(m_renderer, pos);
+	void Widget::DrawPoint(int x, int y, const CoreUI::Color & col)
+	{
+		BATCH().DrawPoint(m_renderer, x, y, col);
 	}
 
 	void Widget::DrawReliefBox(const RectRef pos, const CoreUI::Color & col, bool raised)
 	{
-		SetDrawColor(col);
-
 		// Render rect
-		SDL_RenderFillRect(m_renderer, pos);
+		DrawFilledRect(pos, col);
 
 		Draw3dFrame(pos, !raised);
 
@@ -151,10 +213,8 @@ namespace CoreUI
 
 	void Widget::DrawButton(const RectRef pos, const CoreUI::Color & col, ImageRef image, bool raised, int thickness)
 	{
-		SetDrawColor(col);
-
 		// Render rect
-		SDL_RenderFillRect(m_renderer, pos);
+		DrawFilledRect(pos, col);
 
 		for (int i = 0; i < thickness; ++i)
 		{
@@ -169,7 +229,7 @@ namespace CoreUI
 
 	TexturePtr Widget::SurfaceToTexture(SDL_Surface* surf, bool writable)
 	{
-		TexturePtr texture = TexturePtr(SDL_CreateTextureFromSurface(m_renderer, surf), sdl_deleter());
+		TexturePtr texture = MakeTexture(SDL_CreateTextureFromSurface(m_renderer, surf));
 
 		SDL_FreeSurface(surf);
 
@@ -182,23 +242,24 @@ namespace CoreUI
 		Rect rect;
 
 		SDL_QueryTexture(source.get(), &format, NULL, &rect.w, &rect.h);
-		TextureRef clone = SDL_CreateTexture(m_renderer, format, SDL_TEXTUREACCESS_TARGET, rect.w, rect.h);
-		if (clone && (SDL_SetRenderTarget(m_renderer, clone) == 0))
+		TexturePtr clone = MakeTexture(SDL_CreateTexture(m_renderer, format, SDL_TEXTUREACCESS_TARGET, rect.w, rect.h));
+		if (clone)
 		{
 			if (background.IsTransparent())
 			{
-				SDL_SetTextureBlendMode(clone, SDL_BLENDMODE_BLEND);
+				SDL_SetTextureBlendMode(clone.get(), SDL_BLENDMODE_BLEND);
 			}
-			SetDrawColor(m_backgroundColor);
 
-			if (SDL_SetRenderTarget(m_renderer, clone) == 0)
+			RenderTarget target(m_renderer, clone.get());
+			if (target)
 			{
+				SetDrawColor(m_backgroundColor);
 				SDL_RenderClear(m_renderer); // Needed? transparent vs opaque bg
+				PROFILE_COUNT(renderCopies);
 				SDL_RenderCopy(m_renderer, source.get(), &rect, &rect);
-				SDL_SetRenderTarget(m_renderer, nullptr);
 			}
 		}
-		return std::move(TexturePtr(clone, sdl_deleter()));
+		return std::move(clone);
 	}
 
 
@@ -221,6 +282,7 @@ namespace CoreUI
 	bool Widget::MovePos(PointRef pos)
 	{
 		bool clip = false;
+		InvalidateGeometry();
 
 		m_rect.x = pos->x;
 		m_rect.y = pos->y;
@@ -237,12 +299,14 @@ namespace CoreUI
 			m_rect.y = 0;
 		}
 
+		InvalidateGeometry();
 		return !clip;
 	}
 
 	bool Widget::MoveRel(PointRef rel)
 	{
 		bool clip = false;
+		InvalidateGeometry();
 
 		m_rect.x += rel->x;
 		m_rect.y += rel->y;
@@ -259,12 +323,14 @@ namespace CoreUI
 			m_rect.y = 0;
 		}
 
+		InvalidateGeometry();
 		return !clip;
 	}
 
 	bool Widget::ResizeRel(PointRef rel)
 	{
 		bool clip = false;
+		InvalidateGeometry();
 
 		m_rect.w += rel->x;
 		m_rect.h += rel->y;
@@ -281,12 +347,14 @@ namespace CoreUI
 			m_rect.h = m_minSize.h;
 		}
 
+		InvalidateGeometry();
 		return !clip;
 	}
 
 	bool Widget::Resize(PointRef size)
 	{
 		bool clip = false;
+		InvalidateGeometry();
 
 		m_rect.w = size->x;
 		m_rect.h = size->y;
@@ -303,11 +371,13 @@ namespace CoreUI
 			m_rect.h = m_minSize.h;
 		}
 
+		InvalidateGeometry();
 		return !clip;
 	}
 
 	bool Widget::MoveRect(RectRef rect)
 	{
+		InvalidateGeometry();
 		{
 			Point origin = m_rect.Origin();
 			m_rect.x = rect->x;
@@ -345,6 +415,7 @@ namespace CoreUI
 				m_rect.y = origin.y;
 			}
 		}
+		InvalidateGeometry();
 		return false;
 	}
 
@@ -358,6 +429,30 @@ namespace CoreUI
 	}
 
 	void Widget::PostEvent(EventCode code, void * data2)
+	{
+		m_postedEvents = true;
+		EVENTS().Post({ GetEventClass(), code, this, data2 });
+
+		if (EVENTS().IsSDLBridge())
+		{
+			PushSDLEvent(code, data2);
+		}
+	}
+
+	void Widget::PostChangeEvent(EventCode code, void * data2)
+	{
+		m_postedEvents = true;
+		EVENTS().Post({ GetEventClass(), code, this, data2 }, true);
+
+		if (EVENTS().IsSDLBridge())
+		{
+			// Coalesced in WindowManager::PollEvent
+			WINMGR().AddChangeEvent(GetEventClassId(), code);
+			PushSDLEvent(code, data2);
+		}
+	}
+
+	void Widget::PushSDLEvent(EventCode code, void * data2)
 	{
 		SDL_Event toPost;
 		SDL_zero(toPost);
@@ -376,15 +471,18 @@ namespace CoreUI
 	}
 
 	bool Widget::HandleEvent(SDL_Event* e)
+	{
+		return HandleTooltip(e, nullptr);
+	}
+
+	bool Widget::HandleTooltip(SDL_Event* e, const HitResult * hit)
 	{
 		static Uint32 timerEventID = WINMGR().GetEventType(Timer::EventClassName());
 
-		// Tooltip processing
 		if ((e->type == SDL_MOUSEMOTION) && m_tooltip.size() && (m_tooltipTimer == (Uint32)-1))
 		{
 			Point pt(e->button.x, e->button.y);
-			HitResult hit = HitTest(&pt);
-			if (hit)
+			if (hit ? (bool)*hit : (bool)HitTest(&pt))
 			{
 				// TODO: dynamic delay
 				m_tooltipTimer = WINMGR().AddTimer(300, false, this);
@@ -392,11 +490,11 @@ namespace CoreUI
 		}
 		else if (e->type == timerEventID && e->user.code == m_tooltipTimer)
 		{
+			// Pointer may have moved since the timer was started
 			Point pt;
 			SDL_GetMouseState(&pt.x, &pt.y);
 
-			HitResult hit = HitTest(&pt);
-			if (hit)
+			if (HitTest(&pt))
 			{
 				TOOLTIP().Show(this, pt, m_tooltip.c_str());
 			}
@@ -10,7 +10,9 @@
 #define STRINGIZE( a ) #a
 #define DECLARE_EVENT_CLASS_NAME(className)			\
     static const char* EventClassName() { return STRINGIZE(className); }	\
-    virtual const char* GetClassName() { return EventClassName(); }
+    static ::CoreUI::EventClass EventClassID() { static const ::CoreUI::EventClass id = ::CoreUI::NewEventClass(); return id; }	\
+    virtual const char* GetClassName() { return EventClassName(); }	\
+    virtual ::CoreUI::EventClass GetEventClass() const { return EventClassID(); }
 
 namespace CoreUI
 {
@@ -39,7 +41,7 @@ namespace CoreUI
 	public:
 		DECLARE_EVENT_CLASS_NAME(Widget)
 
-		virtual ~Widget() = default;
+		virtual ~Widget();
 		Widget(const Widget&) = delete;
 		Widget& operator=(const Widget&) = delete;
 		Widget(Widget&&) = delete;
@@ -58,21 +60,28 @@ namespace CoreUI
 		bool IsFocused() { return m_focused; }
 
 		virtual std::string GetText() const { return m_text; }
-		virtual void SetText(const char *text) { m_text = text ? text : ""; }
+		virtual void SetText(const char *text) { if (m_text == (text ? text : "")) return; m_text = text ? text : ""; Invalidate(); }
 
 		virtual ImageRef GetImage() const { return m_image; }
-		virtual void SetImage(ImageRef image) { m_image = image;  }
+		virtual void SetImage(ImageRef image) { if (image == m_image) return; m_image = image; Invalidate(); }
 
 		virtual Rect GetClientRect(bool relative = true, bool scrolled = true) const;
 		virtual Rect GetRect(bool relative = true, bool scrolled = true) const;
-		virtual void SetRect(RectRef rect) { m_rect = rect?(*rect):Rect(); }
+		virtual void SetRect(RectRef rect) { InvalidateGeometry(); m_rect = rect?(*rect):Rect(); InvalidateGeometry(); }
+
+		// Damage tracking: marks the area covered by the widget for repaint.  Setters
+		// don't invalidate when the value doesn't change.
+		virtual void Invalidate();
+		virtual void InvalidateGeometry(); // Position or size changed
+		virtual void ChildInvalidated(); // Called when a child widget changes its appearance
+		virtual void ChildGeometryChanged(WidgetRef) {} // Called when a child widget moves or resizes
 
 		// Margins & Padding
 		virtual Dimension GetMargin() { return m_margin; }
-		virtual void SetMargin(Dimension margin) { m_margin = margin; }
+		virtual void SetMargin(Dimension margin) { if (margin == m_margin) return; m_margin = margin; Invalidate(); }
 
 		virtual Dimension GetPadding() { return m_padding; }
-		virtual void SetPadding(Dimension padding) { m_padding = padding; }
+		virtual void SetPadding(Dimension padding) { if (padding == m_padding) return; m_padding = padding; Invalidate(); }
 
 		// Font
 		virtual const FontRef GetFont() const { return m_font; }
@@ -81,27 +90,27 @@ namespace CoreUI
 		// Borders
 		virtual Dimension GetShrinkFactor() const { return m_padding + m_margin + Dimension(m_showBorder ? m_borderWidth : 0); }
 
-		virtual void SetBorder(bool show) { m_showBorder = show; }
+		virtual void SetBorder(bool show) { if (show == m_showBorder) return; m_showBorder = show; Invalidate(); }
 		virtual bool GetBorder() { return m_showBorder; }
 		
 		virtual Color GetBorderColor() { return m_borderColor; }
-		virtual void SetBorderColor(Color color) { m_borderColor = std::move(color); }
+		virtual void SetBorderColor(Color color) { if (color == m_borderColor) return; m_borderColor = std::move(color); Invalidate(); }
 
 		virtual uint8_t GetBorderWidth() { return m_borderWidth; }
-		virtual void SetBorderWidth(uint8_t width) { m_borderWidth = width; }
+		virtual void SetBorderWidth(uint8_t width) { if (width == m_borderWidth) return; m_borderWidth = width; Invalidate(); }
 
 		// Colors
 		virtual Color GetForegroundColor() { return m_foregroundColor; }
-		virtual void SetForegroundColor(Color color) { m_foregroundColor = std::move(color); }
+		virtual void SetForegroundColor(Color color) { if (color == m_foregroundColor) return; m_foregroundColor = std::move(color); Invalidate(); }
 
 		virtual Color GetBackgroundColor() { return m_backgroundColor; }
-		virtual void SetBackgroundColor(Color color) { m_backgroundColor = std::move(color); }
+		virtual void SetBackgroundColor(Color color) { if (color == m_backgroundColor) return; m_backgroundColor = std::move(color); Invalidate(); }
 
 		virtual Color GetSelectedFgColor() { return m_selectedFgColor; }
-		virtual void SetSelectedFgColor(Color color) { m_selectedFgColor = std::move(color); }
+		virtual void SetSelectedFgColor(Color color) { if (color == m_selectedFgColor) return; m_selectedFgColor = std::move(color); Invalidate(); }
 
 		virtual Color GetSelectedBgColor() { return m_selectedBgColor; }
-		virtual void SetSelectedBgColor(Color color) { m_selectedBgColor = std::move(color); }
+		virtual void SetSelectedBgColor(Color color) { if (color == m_selectedBgColor) return; m_selectedBgColor = std::move(color); Invalidate(); }
 
 		// Tooltip
 		virtual std::string GetTooltip() const { return m_tooltip; }
@@ -124,6 +133,12 @@ namespace CoreUI
 
 		// Events
 		virtual bool HandleEvent(SDL_Event*);
+		// Event routed to this widget by WindowManager::RouteEvent, unhandled events go
+		// to the parent.  'hit' is the router's hit test of the pointer (HIT_NOTHING for
+		// keyboard events), widgets use it instead of testing again.  Containers that
+		// pass events to their children in HandleEvent override it to only handle their
+		// own part.
+		virtual bool HandleOwnEvent(SDL_Event* e, const HitResult & hit) { return HandleEvent(e); }
 		virtual HitResult HitTest(const PointRef) { return HitZone::HIT_NOTHING; }
 
 		virtual PointRef GetScrollPos() { return &m_scrollPos; }
@@ -143,10 +158,20 @@ namespace CoreUI
 
 		Uint32 GetEventClassId();
 
+		// Queued on the event bus (see EventBus), and pushed as an SDL user event if the
+		// bridge is enabled
 		void PostEvent(EventCode code, void * data2 = nullptr);
+		// State change notification, only the latest one is kept while queued
+		void PostChangeEvent(EventCode code, void * data2 = nullptr);
+		void PushSDLEvent(EventCode code, void * data2);
+
+		// Tooltip timer.  'hit' is null if the event wasn't hit tested yet.
+		bool HandleTooltip(SDL_Event* e, const HitResult * hit);
 
 		void SetDrawColor(const CoreUI::Color & col);
 		void DrawFilledRect(const RectRef pos, const CoreUI::Color & col);
+		void DrawLine(int x1, int y1, int x2, int y2, const CoreUI::Color & col);
+		void DrawPoint(int x, int y, const CoreUI::Color & col);
 		void DrawRect(const RectRef pos, const CoreUI::Color & col, int borderWidth = 1);
 		void DrawButton(const RectRef pos, const CoreUI::Color & col, ImageRef image, bool raised, int thickness = 1);
 		void Draw3dFrame(const RectRef pos, bool raised, const CoreUI::Color & col = Color::C_LIGHT_GREY);
@@ -172,6 +197,9 @@ namespace CoreUI
 		std::string m_tooltip;
 		Uint32 m_tooltipTimer = (Uint32)-1;
 
+		bool m_ownsTimers = false; // Timers are deleted with the widget
+		bool m_postedEvents = false; // Queued events are dropped with the widget
+
 		// Borders
 		bool m_showBorder;
 		Color m_borderColor;
@@ -188,6 +216,8 @@ namespace CoreUI
 		uint8_t m_borderWidth;
 
 		static uint8_t constexpr m_buttonSize = 24;
+
+		friend class WindowManager;
 	};
 
 	inline std::ostream & operator << (std::ostream & os, const Widget& widget)
@@ -4,11 +4,16 @@
 #include "Rect.h"
 #include "Window.h"
 #include "Util/ClipRect.h"
+#include "Util/RenderTarget.h"
+#include "DrawBatch.h"
+#include "Profiler.h"
 #include "Widgets/Image.h"
 #include "Widgets/Menu.h"
 #include "Widgets/Toolbar.h"
 #include "ResourceManager.h"
+#include "Tooltip.h"
 #include <algorithm>
+#include <climits>
 
 namespace CoreUI
 {
@@ -41,6 +46,10 @@ namespace CoreUI
 		m_scrollBars = ScrollBars::Create(renderer, this);
 
 		m_backgroundColor = Color::C_LIGHT_GREY;
+		if (m_flags & WIN_BORDERLESS)
+		{
+			m_borderWidth = 0;
+		}
 
 		m_minSize = 120;
 	}
@@ -58,16 +67,53 @@ namespace CoreUI
 
 	void Window::SetFocus(WidgetRef focus, WidgetRef parent)
 	{
+		m_focus = focus;
+
 		// Remove focus from other controls
 		for (auto & control : m_controls)
 		{
-			if (control.second.get() != parent)
+			if (control.get() != parent)
 			{
-				control.second->ClearFocus();
+				control->ClearFocus();
 			}
 		}
 	}
 	
+	void Window::Invalidate()
+	{
+		// Content only: layout and hit testing are unchanged
+		ChildInvalidated();
+		WINMGR().Invalidate(&GetRect(false, true));
+	}
+
+	void Window::InvalidateGeometry()
+	{
+		// Cached content is still valid after a move, only the screen area needs repainting.
+		// A size change is picked up by DrawCached()
+		if (m_parent)
+		{
+			m_parent->ChildInvalidated();
+			GetParentWnd()->GetScrollBars()->ContentChanged();
+		}
+		WINMGR().GeometryChanged();
+		WINMGR().Invalidate(&GetRect(false, true));
+	}
+
+	void Window::ChildGeometryChanged(WidgetRef)
+	{
+		m_controlIndexDirty = true;
+		m_scrollBars->ContentChanged();
+	}
+
+	void Window::ChildInvalidated()
+	{
+		// Changes made while drawing are already part of the frame
+		if (!WINMGR().IsDrawing())
+		{
+			m_cacheDirty = true;
+		}
+	}
+
 	void Window::SetText(const char * title)
 	{
 		Widget::SetText(title);
@@ -77,6 +123,7 @@ namespace CoreUI
 	void Window::Show(bool show)
 	{
 		m_showState = show ? WindowState(m_showState | WST_VISIBLE) : WindowState(m_showState & ~WST_VISIBLE);
+		InvalidateGeometry();
 	}
 
 	void Window::DrawSystemMenuButton(Rect pos, const CoreUI::Color & col)
@@ -113,7 +160,10 @@ namespace CoreUI
 		widget->SetParent(this);
 		widget->Init();
 
-		m_controls[widget->GetId()] = widget;
+		m_controls.push_back(widget);
+		m_controlIds[widget->GetId()] = widget;
+		ChildGeometryChanged(widget.get());
+		widget->Invalidate();
 	}
 
 	WidgetPtr Window::FindControl(const char * id) const
@@ -121,8 +171,8 @@ namespace CoreUI
 		if (id == nullptr)
 			return nullptr;
 
-		auto ctrl = m_controls.find(id);
-		if (ctrl != m_controls.end())
+		auto ctrl = m_controlIds.find(id);
+		if (ctrl != m_controlIds.end())
 		{
 			return ctrl->second;
 		}
@@ -130,7 +180,84 @@ namespace CoreUI
 		return nullptr;
 	}
 
+	bool Window::RemoveControl(const char * id)
+	{
+		WidgetPtr widget = FindControl(id);
+		if (widget == nullptr)
+		{
+			return false;
+		}
+
+		widget->Invalidate();
+		if (WINMGR().GetCapture().Target.target == widget.get())
+		{
+			WINMGR().ReleaseCapture();
+		}
+		TOOLTIP().Hide(widget.get());
+
+		if (m_focus == widget.get())
+		{
+			m_focus = nullptr;
+		}
+
+		m_controls.erase(std::find(m_controls.begin(), m_controls.end(), widget));
+		m_controlIds.erase(widget->GetId());
+		ChildGeometryChanged(widget.get());
+		return true;
+	}
+
+	bool Window::MoveControl(const char * id, size_t pos)
+	{
+		WidgetPtr widget = FindControl(id);
+		if (widget == nullptr)
+		{
+			return false;
+		}
+
+		auto from = std::find(m_controls.begin(), m_controls.end(), widget);
+		auto to = m_controls.begin() + std::min(pos, m_controls.size() - 1);
+		if (from < to)
+		{
+			std::rotate(from, from + 1, to + 1);
+		}
+		else if (to < from)
+		{
+			std::rotate(to, from, from + 1);
+		}
+		else
+		{
+			return true;
+		}
+
+		m_controlIndexDirty = true;
+		widget->Invalidate();
+		return true;
+	}
+
+	bool Window::IsLayoutValid(int slot) const
+	{
+		uint64_t generation = WINMGR().GetGeometryGeneration();
+		if (m_layoutGeneration != generation)
+		{
+			m_layoutGeneration = generation;
+			m_layoutValid = 0;
+		}
+		return (m_layoutValid & (1 << slot)) != 0;
+	}
+
+	const Rect & Window::SetLayout(int slot, const Rect & rect) const
+	{
+		m_layoutValid |= (1 << slot);
+		return m_layout[slot] = rect;
+	}
+
 	Rect Window::GetRect(bool relative, bool scrolled) const
+	{
+		int slot = GetLayoutSlot(LAYOUT_RECT, relative, scrolled);
+		return IsLayoutValid(slot) ? m_layout[slot] : SetLayout(slot, ComputeRect(relative, scrolled));
+	}
+
+	Rect Window::ComputeRect(bool relative, bool scrolled) const
 	{
 		Rect rect = m_rect;
 
@@ -203,6 +330,12 @@ namespace CoreUI
 	}
 
 	Rect Window::GetClientRect(bool relative, bool scrolled) const
+	{
+		int slot = GetLayoutSlot(LAYOUT_CLIENT, relative, scrolled);
+		return IsLayoutValid(slot) ? m_layout[slot] : SetLayout(slot, ComputeClientRect(relative, scrolled));
+	}
+
+	Rect Window::ComputeClientRect(bool relative, bool scrolled) const
 	{
 		uint8_t titleBarHeight = (m_flags & WIN_BORDERLESS) ? 0 : (m_buttonSize + 2);
 
@@ -299,30 +432,18 @@ namespace CoreUI
 		auto titleBar = GetTitleBarRect(rect);
 		if (active)
 		{
-			SetDrawColor(m_activeTitleBarColor);
-			SDL_RenderFillRect(m_renderer, &titleBar);
+			DrawFilledRect(&titleBar, m_activeTitleBarColor);
 		}
 		else
 		{
-			SetDrawColor(Color::C_LIGHT_GREY);
-			SDL_RenderFillRect(m_renderer, &titleBar);
+			DrawFilledRect(&titleBar, Color::C_LIGHT_GREY);
 			Draw3dFrame(&titleBar, true);
 		}
 	}
 
 	void Window::DrawTitle(Rect rect, bool active)
 	{
-		TexturePtr title;
-		if (active && m_activeTitle)
-		{
-			title = m_activeTitle;
-		}
-		else if (!active && m_inactiveTitle)
-		{
-			title = m_inactiveTitle;
-		}
-
-		if (title)
+		if (!m_titleStrRect.IsEmpty())
 		{
 			Rect target = GetTitleBarRect(rect);
 
@@ -332,13 +453,13 @@ namespace CoreUI
 			target.w = std::min(m_titleStrRect.w, target.w - (m_buttonSize / 2));
 			target.h = std::min(m_titleStrRect.h, target.h);
 
-			Rect source = { 0, 0, target.w, target.h };
-			SDL_RenderCopy(m_renderer, title.get(), &source, &target);
+			RES().GetGlyphAtlas().DrawText(m_titleFont, m_text.c_str(), &target.Origin(), active ? Color::C_WHITE : Color::C_DARK_GREY, &target);
 		}
 	}
 
 	HitResult Window::HitTest(const PointRef pt)
 	{
+		PROFILE_SCOPE(PROFILE_HITTEST, this);
 		if (!(m_showState & WST_VISIBLE))
 		{
 			return HitZone::HIT_NOTHING;
@@ -362,13 +483,10 @@ namespace CoreUI
 		}
 		else if (GetClientRect(false, false).PointInRect(pt))
 		{
-			for (auto & child : m_controls)
+			HitResult childHit = HitTestControls(pt);
+			if (childHit)
 			{
-				HitResult childHit = child.second->HitTest(pt);
-				if (childHit)
-				{
-					return childHit;
-				}
+				return childHit;
 			}
 			return HitResult(HitZone::HIT_CLIENT, this);
 		}
@@ -447,17 +565,80 @@ namespace CoreUI
 		return HIT_NOTHING;
 	}
 
-	Rect Window::GetClipRect(WindowRef win)
+	HitResult Window::HitTestControls(const PointRef pt)
 	{
-		Rect rect = win->GetClientRect(false, false);
+		if (!WINMGR().IsHitTestIndexed())
+		{
+			// Topmost first
+			for (auto it = m_controls.rbegin(); it != m_controls.rend(); ++it)
+			{
+				HitResult childHit = (*it)->HitTest(pt);
+				if (childHit)
+				{
+					return childHit;
+				}
+			}
+			return HIT_NOTHING;
+		}
+
+		UpdateControlIndex();
+
+		// Controls are placed in the scrolled client area, some test against the unscrolled one
+		Point origin = GetClientRect(false, false).Origin();
+		PointRef scroll = GetScrollPos();
+		Point pts[2] = {
+			Point(pt->x - origin.x, pt->y - origin.y),
+			Point(pt->x - origin.x + scroll->x, pt->y - origin.y + scroll->y) };
 
-		while (win)
+		m_controlCandidates.clear();
+		m_controlIndex.Query(pts, 2, m_controlCandidates);
+
+		for (auto it = m_controlCandidates.rbegin(); it != m_controlCandidates.rend(); ++it)
 		{
-			rect = rect.IntersectRect(&win->GetClientRect(false, false));
-			win = win->GetParentWnd();
+			HitResult childHit = (*it)->HitTest(pt);
+			if (childHit)
+			{
+				return childHit;
+			}
 		}
+		return HIT_NOTHING;
+	}
 
-		return rect;
+	void Window::UpdateControlIndex()
+	{
+		if (!m_controlIndexDirty)
+			return;
+
+		// Same order as m_controls.  WIN_FILL controls cover the whole client area,
+		// they go in the grid with a rect that won't fit any cell.
+		const Rect fill(INT_MIN / 2, INT_MIN / 2, INT_MAX, INT_MAX);
+
+		m_controlIndex.Clear();
+		m_controlBounds.clear();
+		for (auto & child : m_controls)
+		{
+			WidgetRef control = child.get();
+			Rect rect = (control->GetFlags() & WIN_FILL) ? fill : control->GetRect(true, false);
+			m_controlIndex.Insert(rect, control);
+			m_controlBounds.push_back({ control, rect });
+		}
+		m_controlIndexDirty = false;
+	}
+
+	Rect Window::GetClipRect(WindowRef win)
+	{
+		// Client area clipped by the client areas of the parents
+		if (win->IsLayoutValid(LAYOUT_CLIP))
+		{
+			return win->m_layout[LAYOUT_CLIP];
+		}
+
+		Rect rect = win->GetClientRect(false, false);
+		if (win->GetParentWnd())
+		{
+			rect = rect.IntersectRect(&GetClipRect(win->GetParentWnd()));
+		}
+		return win->SetLayout(LAYOUT_CLIP, rect);
 	}
 
 	void Window::Draw()
@@ -465,6 +646,74 @@ namespace CoreUI
 		if (!(m_showState & WST_VISIBLE))
 			return;
 
+		if (CanCache() && DrawCached())
+			return;
+
+		DrawWindow();
+	}
+
+	bool Window::CanCache()
+	{
+		if (!(m_flags & WIN_CACHED) || m_parent)
+			return false;
+
+		return WINMGR().SupportsRenderTargets(m_renderer);
+	}
+
+	bool Window::DrawCached()
+	{
+		Rect rect = GetRect(false);
+		if (rect.IsEmpty())
+			return true;
+
+		if (!m_cache || m_cacheSize.x != rect.w || m_cacheSize.y != rect.h)
+		{
+			m_cache = MakeTexture(SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, rect.w, rect.h));
+			if (!m_cache)
+			{
+				return false;
+			}
+			SDL_SetTextureBlendMode(m_cache.get(), SDL_BLENDMODE_BLEND);
+			m_cacheSize = rect.Size();
+			m_cacheDirty = true;
+		}
+
+		if (m_cacheDirty)
+		{
+			Rect baseClip = ClipRect::GetBaseClip();
+			{
+				// The texture's origin is the window's position, the window draws at its usual screen coordinates
+				RenderTarget target(m_renderer, m_cache.get(), rect.Origin());
+				if (!target)
+				{
+					return false;
+				}
+
+				PROFILE_COUNT(drawColorChanges);
+				SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0);
+				SDL_RenderClear(m_renderer);
+
+				ClipRect::SetBaseClip(&rect);
+
+				DrawWindow();
+			}
+			ClipRect::SetBaseClip(&baseClip);
+
+			m_cacheDirty = false;
+		}
+
+		ClipRect clip(m_renderer, nullptr, false);
+		if (clip && CLIP().IsVisible(rect))
+		{
+			BATCH().Flush();
+			PROFILE_COUNT(renderCopies);
+			SDL_RenderCopy(m_renderer, m_cache.get(), nullptr, &CLIP().ToTarget(rect));
+		}
+		return true;
+	}
+
+	void Window::DrawWindow()
+	{
 		ClipRect clip(m_renderer, m_parent ? &GetClipRect(GetParentWnd()) : nullptr, m_parent);
 		if (clip || m_parent == nullptr)
 		{
@@ -472,11 +721,7 @@ namespace CoreUI
 
 			bool active = (WINMGR().GetActive() == this || (m_flags & WIN_ACTIVE));
 
-			if (m_flags & WIN_BORDERLESS)
-			{
-				SetBorderWidth(0);
-			}
-			else
+			if (!(m_flags & WIN_BORDERLESS))
 			{
 				if (m_flags & WIN_DIALOG)
 				{
@@ -545,13 +790,12 @@ namespace CoreUI
 		int gridSize = m_grid.GetSize();
 		if (m_grid.IsVisible() && gridSize > 1)
 		{
-			SetDrawColor(Color::C_BLACK);
 			Rect clientRect = GetClientRect(false, true);
 			for (int x = clientRect.x; x < clientRect.x + clientRect.w; x += gridSize)
 			{
 				for (int y = clientRect.y; y < clientRect.y + clientRect.h; y += gridSize)
 				{
-					SDL_RenderDrawPoint(m_renderer, x, y);
+					DrawPoint(x, y, Color::C_BLACK);
 				}
 			}
 		}
@@ -582,13 +826,28 @@ namespace CoreUI
 
 	void Window::DrawControls()
 	{
-		ClipRect clip(m_renderer, &GetClientRect(false, false));
+		PROFILE_SCOPE(PROFILE_CONTROLS, this);
+		Rect client = GetClientRect(false, false);
+		ClipRect clip(m_renderer, &client);
 		if (clip)
 		{
-			for (auto & ctrl : m_controls)
+			UpdateControlIndex();
+
+			// Visible part of the client area, in the same coordinates as the control rects
+			PointRef scroll = GetScrollPos();
+			Rect visible = clip.GetClipRegion()->Offset(&Point(scroll->x - client.x, scroll->y - client.y));
+
+			uint32_t drawn = 0;
+			for (auto & bounds : m_controlBounds)
 			{
-				ctrl.second->Draw();
+				if (bounds.rect.HasIntersection(&visible))
+				{
+					PROFILE_SCOPE(PROFILE_DRAW, bounds.control);
+					bounds.control->Draw();
+					++drawn;
+				}
 			}
+			WINMGR().AddControlStats(drawn, (uint32_t)m_controlBounds.size() - drawn);
 		}
 	}
 
@@ -605,19 +864,20 @@ namespace CoreUI
 			throw std::invalid_argument("no font");
 		}
 
-		SDL_Surface* active = TTF_RenderText_Blended(titleFont, m_text.c_str(), CoreUI::Color::C_WHITE);
-		m_activeTitle = SurfaceToTexture(active);
-
-		SDL_Surface* inactive = TTF_RenderText_Blended(titleFont, m_text.c_str(), CoreUI::Color::C_DARK_GREY);
-		m_inactiveTitle = SurfaceToTexture(inactive);
-
-		SDL_QueryTexture(m_activeTitle.get(), NULL, NULL, &m_titleStrRect.w, &m_titleStrRect.h);
-		m_titleStrRect.x = 0;
-		m_titleStrRect.y = 0;
+		// Drawn from the glyph atlas, only the size is needed
+		m_titleFont = titleFont;
+		Point size = RES().GetGlyphAtlas().GetTextSize(m_titleFont, m_text.c_str());
+		m_titleStrRect = Rect(0, 0, size.x, size.y);
 	}
 
 	void Window::ToggleButtonState(HitZone button, bool pushed)
 	{
+		if (((m_pushedState & button) != 0) == pushed)
+		{
+			return;
+		}
+
+		Invalidate();
 		if (pushed)
 		{
 			m_pushedState = HitZone(m_pushedState | button);
@@ -720,8 +980,10 @@ namespace CoreUI
 		}
 		else
 		{
+			InvalidateGeometry();
 			m_showState = WindowState(m_showState | WST_MINIMIZED);
 			m_showState = WindowState(m_showState & ~WST_MAXIMIZED);
+			InvalidateGeometry();
 
 			GetParentWnd()->SetMinimizedChild(this, true);
 		}
@@ -741,8 +1003,10 @@ namespace CoreUI
 		else
 		{
 			m_scrollBars->ScrollTo(&Point({ 0,0 }));
+			InvalidateGeometry();
 			m_showState = WindowState(m_showState | WST_MAXIMIZED);
 			m_showState = WindowState(m_showState & ~WST_MINIMIZED);
+			InvalidateGeometry();
 		}
 	}
 
@@ -753,7 +1017,9 @@ namespace CoreUI
 			return;
 		}
 
+		InvalidateGeometry();
 		m_showState = WindowState(m_showState & ~(WST_MAXIMIZED | WST_MINIMIZED));
+		InvalidateGeometry();
 	}
 
 	int Window::GetMinimizedChildIndex(WindowRef child) const
@@ -792,12 +1058,27 @@ namespace CoreUI
 				*find = nullptr;
 			}
 		}
+
+		// Minimized windows are placed by their index
+		WINMGR().GeometryChanged();
 	}
 
 	bool Window::HandleEvent(SDL_Event * e)
+	{
+		PROFILE_SCOPE(PROFILE_EVENT, this);
+		Point pt(e->button.x, e->button.y);
+		return HandleFrameEvent(e, HitTest(&pt), true) || HandleChildEvent(e) || HandleScrollKeys(e);
+	}
+
+	bool Window::HandleOwnEvent(SDL_Event * e, const HitResult & hit)
+	{
+		// The router already set the cursor, controls may have changed it
+		return HandleFrameEvent(e, hit, false) || HandleScrollKeys(e);
+	}
+
+	bool Window::HandleFrameEvent(SDL_Event * e, const HitResult & hit, bool setCursor)
 	{
 		Point pt(e->button.x, e->button.y);
-		HitResult hit = HitTest(&pt);
 
 		if (e->type == SDL_MOUSEBUTTONDOWN)
 		{
@@ -952,7 +1233,10 @@ namespace CoreUI
 					SDL_SetCursor(RES().FindCursor("default"));
 					break;
 				default:
-					SDL_SetCursor(RES().FindCursor("default"));
+					if (setCursor)
+					{
+						SDL_SetCursor(RES().FindCursor("default"));
+					}
 					handled = false;
 				}
 
@@ -963,28 +1247,43 @@ namespace CoreUI
 			}
 		}
 
-		// Pass to menu
-		if (m_menu && m_menu->HandleEvent(e))
+		return false;
+	}
+
+	bool Window::HandleChildEvent(SDL_Event * e)
+	{
+		if (m_menu)
 		{
-			return true;
+			PROFILE_SCOPE(PROFILE_EVENT, m_menu.get());
+			if (m_menu->HandleEvent(e))
+			{
+				return true;
+			}
 		}
 
-		if (m_toolbar && m_toolbar->HandleEvent(e))
+		if (m_toolbar)
 		{
-			return true;
+			PROFILE_SCOPE(PROFILE_EVENT, m_toolbar.get());
+			if (m_toolbar->HandleEvent(e))
+			{
+				return true;
+			}
 		}
 
-		// Pass to controls
+		// Topmost first
+		for (auto it = m_controls.rbegin(); it != m_controls.rend(); ++it)
 		{
-			for (auto & child : m_controls)
+			PROFILE_SCOPE(PROFILE_EVENT, it->get());
+			if ((*it)->HandleEvent(e))
 			{
-				if (child.second->HandleEvent(e))
-				{
-					return true;
-				}
+				return true;
 			}
 		}
+		return false;
+	}
 
+	bool Window::HandleScrollKeys(SDL_Event * e)
+	{
 		if (e->type == SDL_KEYDOWN && GetScrollBars())
 		{
 			switch (e->key.keysym.sym)
@@ -1008,6 +1307,7 @@ namespace CoreUI
 		m_menu = menu; 
 		m_menu->SetParent(this); 
 		m_menu->Init();
+		InvalidateGeometry(); // Client area changed
 	}
 
 	void Window::SetToolbar(ToolbarPtr toolbar)
@@ -1015,6 +1315,7 @@ namespace CoreUI
 		m_toolbar = toolbar;
 		m_toolbar->SetParent(this);
 		m_toolbar->Init();
+		InvalidateGeometry(); // Client area changed
 	}
 
 	struct Window::shared_enabler : public Window
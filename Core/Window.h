@@ -7,6 +7,7 @@
 #include "WindowManager.h"
 #include "Widgets/ScrollBars.h"
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace CoreUI
@@ -23,7 +24,9 @@ namespace CoreUI
 		DECLARE_EVENT_CLASS_NAME(Window)
 
 		using MinWindowList = std::vector<WindowRef>;
-		using ControlList = std::map<std::string, WidgetPtr>;
+		using ChildWindowList = std::vector<WindowRef>;
+		using ControlList = std::vector<WidgetPtr>; // In z-order, topmost last
+		using ControlIdMap = std::unordered_map<std::string, WidgetPtr>;
 
 		virtual ~Window() = default;
 		Window(const Window&) = delete;
@@ -35,14 +38,24 @@ namespace CoreUI
 
 		static WindowPtr Create(const char* id, RendererRef renderer, WindowRef parent, FontRef font, Rect rect, CreationFlags flags);
 		void SetText(const char * text) override;
+		void SetBorderWidth(uint8_t width) override { if (width == m_borderWidth) return; m_borderWidth = width; InvalidateGeometry(); } // Resizes the client area
 
 		void SetActive() override;
 		void SetFocus(WidgetRef focus, WidgetRef parent = nullptr) override;
 
+		void Invalidate() override;
+		void InvalidateGeometry() override;
+		void ChildInvalidated() override;
+		void ChildGeometryChanged(WidgetRef child) override;
+
 		WindowManager::WindowList GetChildWindows();
+		const ChildWindowList & GetChildWindowRefs() const { return m_childWindows; } // In z-order
 
-		void AddControl(WidgetPtr);
+		void AddControl(WidgetPtr); // On top of the other controls
 		WidgetPtr FindControl(const char* id) const;
+		bool RemoveControl(const char* id);
+		// Moves a control to position 'pos' in the z-order (0: bottom), past the end puts it on top
+		bool MoveControl(const char* id, size_t pos);
 		const ControlList &GetControls() const { return m_controls; }
 
 		WindowRef GetParentWnd() const { return static_cast<WindowRef>(m_parent); }
@@ -75,6 +88,10 @@ namespace CoreUI
 		Grid& GetGrid() { return m_grid; }
 
 		bool HandleEvent(SDL_Event *) override;
+		bool HandleOwnEvent(SDL_Event *, const HitResult &) override;
+
+		// Control with the keyboard focus, nullptr if none
+		WidgetRef GetFocus() const { return (m_focus && m_focus->IsFocused()) ? m_focus : nullptr; }
 
 		ScrollBarsRef GetScrollBars() { return m_scrollBars.get(); }
 
@@ -102,6 +119,9 @@ namespace CoreUI
 		void DrawSystemMenuButton(Rect pos, const CoreUI::Color & col);
 		void DrawTitleBar(Rect rect, bool active);
 		void DrawTitle(Rect rect, bool active);
+		void DrawWindow();
+		bool DrawCached();
+		bool CanCache();
 		void DrawControls();
 		void DrawMenu();
 		void DrawToolbar();
@@ -110,27 +130,71 @@ namespace CoreUI
 
 		Rect GetClipRect(WindowRef win);
 
+		// Geometry cache, valid until the window manager's geometry generation moves
+		enum LayoutSlot { LAYOUT_RECT = 0, LAYOUT_CLIENT = 4, LAYOUT_CLIP = 8, LAYOUT_COUNT };
+		static int GetLayoutSlot(LayoutSlot base, bool relative, bool scrolled) { return base + (relative ? 2 : 0) + (scrolled ? 1 : 0); }
+		bool IsLayoutValid(int slot) const;
+		const Rect & SetLayout(int slot, const Rect & rect) const;
+
+		Rect ComputeRect(bool relative, bool scrolled) const;
+		Rect ComputeClientRect(bool relative, bool scrolled) const;
+
+		HitResult HitTestControls(const PointRef pt);
+
+		// Parts of HandleEvent
+		bool HandleFrameEvent(SDL_Event * e, const HitResult & hit, bool setCursor);
+		bool HandleChildEvent(SDL_Event * e);
+		bool HandleScrollKeys(SDL_Event * e);
+		void UpdateControlIndex();
+
 		WindowState m_showState;
 		HitZone m_pushedState;
 
 		static const Color m_activeTitleBarColor;
 
-		TexturePtr m_activeTitle;
-		TexturePtr m_inactiveTitle;
+		FontRef m_titleFont = nullptr;
 		Rect m_titleStrRect;
 
 		MinWindowList m_minimizedChildren;
+
+		// Maintained by WindowManager
+		ChildWindowList m_childWindows;
+		WindowManager::WindowList::iterator m_zOrderPos;
 		ScrollBarsPtr m_scrollBars;
 
 		static Window m_nullWnd;			
 
 		ControlList m_controls;
+		ControlIdMap m_controlIds;
+		WidgetRef m_focus = nullptr;
+
+		// Control rects relative to the client area, for hit testing and culling
+		using ControlIndex = SpatialGrid<WidgetRef>;
+		ControlIndex m_controlIndex;
+		bool m_controlIndexDirty = true;
+		std::vector<WidgetRef> m_controlCandidates;
+
+		struct ControlBounds
+		{
+			WidgetRef control;
+			Rect rect;
+		};
+		std::vector<ControlBounds> m_controlBounds; // Same order as m_controls
 
 		MenuPtr m_menu;
 		ToolbarPtr m_toolbar;
 
 		Grid m_grid;
 
+		mutable Rect m_layout[LAYOUT_COUNT];
+		mutable uint16_t m_layoutValid = 0;
+		mutable uint64_t m_layoutGeneration = 0;
+
+		// Offscreen cache (WIN_CACHED)
+		TexturePtr m_cache;
+		Point m_cacheSize;
+		bool m_cacheDirty = true;
+
 		struct shared_enabler;
 
 		friend class ScrollBars;
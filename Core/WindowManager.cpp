@@ -4,6 +4,11 @@
 #include "WindowManager.h"
 #include "Window.h"
 #include "Tooltip.h"
+#include "Widgets/Menu.h"
+#include "DrawBatch.h"
+#include "EventBus.h"
+#include "Util/ClipRect.h"
+#include "Util/RenderTarget.h"
 #include <algorithm>
 #include <iostream>
 
@@ -25,8 +30,29 @@ namespace CoreUI
 	}
 #endif
 
+	static size_t s_textureCount = 0;
+
+	TexturePtr MakeTexture(TextureRef texture)
+	{
+		if (texture == nullptr)
+		{
+			return nullptr;
+		}
+
+		++s_textureCount;
+		PROFILE_COUNT(texturesCreated);
+		return TexturePtr(texture, [](TextureRef p) { SDL_DestroyTexture(p); --s_textureCount; });
+	}
+
+	size_t GetTextureCount()
+	{
+		return s_textureCount;
+	}
+
 	WindowManager & WindowManager::Get()
 	{
+		// Constructed first so it outlives the widgets
+		EVENTS();
 		static WindowManager manager;
 		return manager;
 	}
@@ -42,22 +68,140 @@ namespace CoreUI
 
 	void WindowManager::Dispose()
 	{
+		PROFILER().ShowOverlay(false);
 		m_activeWindow = nullptr;
 		m_capture = CaptureInfo();
 		m_windowSize = Rect();
 		m_screenResolutions.clear();
+		m_targetsRenderer = nullptr;
 
 		m_registeredEvents.clear();
 		m_registeredEventsReverse.clear();
-		m_timers.clear();
+		m_changeEvents.clear();
+		m_eventStats = EventStats();
+		m_lastEventStats = EventStats();
+		m_timerWheel.Clear();
+		EVENTS().ClearQueue();
 
 		m_windows.clear();
+		m_windowIds.clear();
+		m_hitIndex.Clear();
+		GeometryChanged();
+
+		m_damage.clear();
+		m_deferredDamage.clear();
+		m_frameCache = nullptr;
+		m_frameCacheRect = Rect();
+		m_frameDrawn = false;
+	}
+
+	bool WindowManager::Draw()
+	{
+		m_lastEventStats = m_eventStats;
+		m_eventStats = EventStats();
+
+		Tick(SDL_GetTicks());
+		EVENTS().Dispatch();
+		m_frameDrawn = true;
+
+		bool repainted;
+		if (!Profiler::IsEnabled())
+		{
+			repainted = DrawFrame();
+		}
+		else
+		{
+			// Overlay text changes outside of drawing, so it is part of this frame
+			PROFILER().UpdateOverlay();
+
+			Profiler::Clock::time_point start = Profiler::Clock::now();
+			repainted = DrawFrame();
+			std::chrono::duration<double, std::milli> elapsed = Profiler::Clock::now() - start;
+			PROFILER().EndFrame(elapsed.count());
+		}
+
+		// Changes made while drawing may have missed parts already drawn
+		DamageList deferred;
+		deferred.swap(m_deferredDamage);
+		for (auto & damage : deferred)
+		{
+			Invalidate(&damage);
+		}
+		return repainted;
+	}
+
+	bool WindowManager::DrawFrame()
+	{
+		// The host may have changed the clip rect since the last frame
+		CLIP().Reset();
+		m_drawnControls = 0;
+		m_culledControls = 0;
+
+		Rect screen = GetWindowSize();
+
+		if (!m_retainedMode)
+		{
+			m_damage.clear();
+			DrawWindows();
+			m_repaintedPixels = (uint64_t)screen.w * screen.h;
+			return true;
+		}
+
+		if (!m_frameCache || !m_frameCacheRect.IsEqual(&screen))
+		{
+			m_frameCache = MakeTexture(SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, screen.w, screen.h));
+			if (!m_frameCache)
+			{
+				std::cerr << "Unable to create frame cache, disabling retained mode" << std::endl;
+				m_retainedMode = false;
+				return DrawFrame();
+			}
+			m_frameCacheRect = screen;
+			m_damage.clear();
+			m_damage.push_back(screen);
+		}
+
+		m_repaintedPixels = 0;
+		bool repainted = !m_damage.empty();
+		if (repainted)
+		{
+			RenderTarget target(m_renderer, m_frameCache.get());
+			if (target)
+			{
+				for (auto & damage : m_damage)
+				{
+					ClipRect clip(m_renderer, &damage, false);
+					ClipRect::SetBaseClip(&damage);
+
+					PROFILE_COUNT(drawColorChanges);
+					SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 255);
+					PROFILE_COUNT(primitiveCalls);
+					SDL_RenderFillRect(m_renderer, &damage);
+					DrawWindows(&damage);
+
+					m_repaintedPixels += (uint64_t)damage.w * damage.h;
+				}
+				ClipRect::SetBaseClip(nullptr);
+			}
+			m_damage.clear();
+		}
+
+		PROFILE_COUNT(renderCopies);
+		SDL_RenderCopy(m_renderer, m_frameCache.get(), nullptr, nullptr);
+		return repainted;
 	}
 
-	void WindowManager::Draw()
+	void WindowManager::DrawWindows(RectRef damage)
 	{
+		m_drawing = true;
+
 		for (auto & window : m_windows)
 		{
+			// Clipped away anyway, skipping saves walking the window's controls
+			if (damage && !window->GetRect(false).HasIntersection(damage))
+				continue;
+
+			PROFILE_SCOPE(PROFILE_DRAW, window.get());
 			window->Draw();
 		}
 
@@ -71,6 +215,78 @@ namespace CoreUI
 		{
 			m_tooltipWindow->Draw();
 		}
+
+		BATCH().Flush();
+		m_drawing = false;
+	}
+
+	void WindowManager::SetRetainedMode(bool retained)
+	{
+		m_retainedMode = retained;
+		m_frameCache = nullptr;
+		m_frameCacheRect = Rect();
+		m_damage.clear();
+		m_deferredDamage.clear();
+		m_frameDrawn = false;
+	}
+
+	bool WindowManager::NeedsRedraw() const
+	{
+		if (!m_frameDrawn || !m_damage.empty() || EVENTS().GetQueuedCount())
+			return true;
+
+		Rect screen = GetWindowSize();
+		return m_retainedMode && (m_frameCacheRect.w != screen.w || m_frameCacheRect.h != screen.h);
+	}
+
+	int WindowManager::GetWaitTimeout(Uint32 now) const
+	{
+		if (NeedsRedraw())
+			return 0;
+
+		Uint32 deadline;
+		if (!GetNextDeadline(deadline))
+			return -1;
+
+		// Ticks wrap around
+		Sint32 remaining = (Sint32)(deadline - now);
+		return std::max(remaining, 0);
+	}
+
+	void WindowManager::Invalidate(RectRef rect)
+	{
+		Rect screen = GetWindowSize();
+		Rect damage = rect ? rect->IntersectRect(&screen) : screen;
+		if (damage.IsEmpty())
+			return;
+
+		// The damage list is in use, applied after the frame
+		if (m_drawing)
+		{
+			m_deferredDamage.push_back(damage);
+			return;
+		}
+
+		for (auto & it : m_damage)
+		{
+			if (it.HasIntersection(&damage))
+			{
+				it = it.UnionRect(&damage);
+				return;
+			}
+		}
+
+		if (m_damage.size() >= m_maxDamageRects)
+		{
+			// Too fragmented, fall back to a single bounding rect
+			for (auto & it : m_damage)
+			{
+				damage = damage.UnionRect(&it);
+			}
+			m_damage.clear();
+		}
+
+		m_damage.push_back(damage);
 	}
 
 	WindowPtr WindowManager::AddWindowFill(const char * id, CreationFlags flags)
@@ -100,8 +316,15 @@ namespace CoreUI
 		else
 		{
 			m_windows.push_back(newWindow);
+			newWindow->m_zOrderPos = std::prev(m_windows.end());
+			m_windowIds[newWindow->GetId()] = newWindow.get();
+			if (parent)
+			{
+				parent->m_childWindows.push_back(newWindow.get());
+			}
 		}
 
+		newWindow->InvalidateGeometry();
 		return newWindow;
 	}
 
@@ -116,12 +339,10 @@ namespace CoreUI
 			return m_tooltipWindow;
 		}
 
-		for (auto & it : m_windows)
+		auto found = m_windowIds.find(id);
+		if (found != m_windowIds.end())
 		{
-			if (id == it->GetId())
-			{
-				return it;
-			}
+			return *found->second->m_zOrderPos;
 		}
 
 		return nullptr;
@@ -131,6 +352,10 @@ namespace CoreUI
 	{
 		if (id == Tooltip::GetId())
 		{
+			if (m_tooltipWindow)
+			{
+				m_tooltipWindow->Invalidate();
+			}
 			m_tooltipWindow = nullptr;
 			return true;
 		}
@@ -140,7 +365,15 @@ namespace CoreUI
 		{
 			return false;
 		}
-		m_windows.remove(wnd);
+		wnd->InvalidateGeometry();
+		if (wnd->HasParent())
+		{
+			auto & siblings = wnd->GetParentWnd()->m_childWindows;
+			siblings.erase(std::find(siblings.begin(), siblings.end(), wnd.get()));
+		}
+		m_windowIds.erase(wnd->GetId());
+		m_windows.erase(wnd->m_zOrderPos);
+		GeometryChanged();
 		if (m_activeWindow == wnd.get())
 		{
 			m_activeWindow = nullptr;
@@ -151,13 +384,43 @@ namespace CoreUI
 	WindowManager::WindowList WindowManager::GetWindowList(WindowRef parent)
 	{
 		WindowList childWindows;
-		std::copy_if(m_windows.begin(), m_windows.end(), std::back_inserter(childWindows),
-			[parent](WindowPtr window) { return window->GetParent() == parent; });
+		if (parent)
+		{
+			for (auto & child : parent->m_childWindows)
+			{
+				childWindows.push_back(*child->m_zOrderPos);
+			}
+		}
+		else
+		{
+			std::copy_if(m_windows.begin(), m_windows.end(), std::back_inserter(childWindows),
+				[](WindowPtr window) { return !window->HasParent(); });
+		}
 		return childWindows;
 	}
 
 	HitResult WindowManager::HitTest(PointRef pt)
 	{
+		PROFILE_SCOPE(PROFILE_HITTEST, nullptr);
+		if (m_hitTestIndex)
+		{
+			UpdateHitIndex();
+
+			m_hitCandidates.clear();
+			m_hitIndex.Query(*pt, m_hitCandidates);
+
+			// Inserted bottom to top
+			for (auto it = m_hitCandidates.rbegin(); it != m_hitCandidates.rend(); ++it)
+			{
+				auto hitResult = (*it)->HitTest(pt);
+				if (hitResult)
+				{
+					return hitResult;
+				}
+			}
+			return HIT_NOTHING;
+		}
+
 		for (auto it = m_windows.rbegin(); it != m_windows.rend(); ++it)
 		{
 			auto & window = *it;
@@ -172,6 +435,28 @@ namespace CoreUI
 		return HIT_NOTHING;
 	}
 
+	void WindowManager::UpdateHitIndex()
+	{
+		if (m_hitIndexGeneration == m_geometryGeneration)
+			return;
+
+		// A window can only be hit inside its rect clipped by its parents
+		m_hitIndex.Clear();
+		for (auto & window : m_windows)
+		{
+			if (!(window->GetShowState() & WST_VISIBLE))
+				continue;
+
+			Rect rect = window->GetRect(false);
+			if (window->HasParent())
+			{
+				rect = rect.IntersectRect(&window->GetClipRect(window->GetParentWnd()));
+			}
+			m_hitIndex.Insert(rect, window.get());
+		}
+		m_hitIndexGeneration = m_geometryGeneration;
+	}
+
 	CoreUI::WindowRef WindowManager::GetActive()
 	{
 		return m_activeWindow ? m_activeWindow : Window::GetNullWnd();
@@ -187,6 +472,7 @@ namespace CoreUI
 		if (m_activeWindow)
 		{
 			m_activeWindow->PostEvent(Window::EVENT_WINDOW_DEACTIVATED);
+			m_activeWindow->Invalidate();
 		}
 		
 		m_activeWindow = win;
@@ -194,6 +480,7 @@ namespace CoreUI
 		if (m_activeWindow)
 		{
 			m_activeWindow->PostEvent(Window::EVENT_WINDOW_ACTIVATED);
+			m_activeWindow->Invalidate();
 		}
 
 		MoveToFront(win);
@@ -212,62 +499,296 @@ namespace CoreUI
 		return m_capture;
 	}
 
-	Uint32 timerCallbackFunc(Uint32 interval, void *param)
+	bool WindowManager::RouteEvent(SDL_Event * e)
 	{
-		static Uint32 timerEventID = WINMGR().GetEventType(Timer::EventClassName());
-		if (timerEventID == (Uint32)-1)
-			return -1;
+		switch (e->type)
+		{
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+		case SDL_TEXTINPUT:
+		case SDL_TEXTEDITING:
+		{
+			if (m_capture)
+			{
+				return BubbleEvent(m_capture.Target.target, e, HitResult());
+			}
+
+			if (m_activeWindow == nullptr)
+			{
+				return false;
+			}
+
+			// Menu hotkeys come before the focused control
+			MenuPtr menu = m_activeWindow->GetMenu();
+			if (e->type == SDL_KEYDOWN && menu && menu->HandleEvent(e))
+			{
+				return true;
+			}
+
+			WidgetRef focus = m_activeWindow->GetFocus();
+			return BubbleEvent(focus ? focus : m_activeWindow, e, HitResult());
+		}
+		case SDL_MOUSEMOTION:
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEWHEEL:
+		{
+			Point pt(e->button.x, e->button.y);
+			if (e->type == SDL_MOUSEWHEEL)
+			{
+				SDL_GetMouseState(&pt.x, &pt.y);
+			}
+
+			if (m_capture)
+			{
+				// Only the captured widget is tested, i.e. a pushed button checks the pointer is still over it
+				WidgetRef target = m_capture.Target.target;
+				return BubbleEvent(target, e, target->HitTest(&pt));
+			}
+
+			if (e->type == SDL_MOUSEMOTION)
+			{
+				// Widgets with another cursor set it when they get the event
+				SDL_SetCursor(RES().FindCursor("default"));
+			}
+
+			HitResult hit = HitTest(&pt);
+			return hit ? BubbleEvent(hit.target, e, hit) : false;
+		}
+		default:
+			break;
+		}
+
+		// Not aimed at a particular widget.  Handlers may add or remove windows.
+		WindowList windows = m_windows;
+		for (auto it = windows.rbegin(); it != windows.rend(); ++it)
+		{
+			if ((*it)->HandleEvent(e))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool WindowManager::PollEvent(SDL_Event * e)
+	{
+		while (SDL_PollEvent(e))
+		{
+			if (PreprocessEvent(e))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool WindowManager::WaitEvent(SDL_Event * e)
+	{
+		if (!SDL_WaitEventTimeout(e, GetWaitTimeout()))
+		{
+			return false;
+		}
 
-		SDL_Event timerEvent;
-		SDL_zero(timerEvent);
+		// A dropped event has a later one queued
+		return PreprocessEvent(e) || PollEvent(e);
+	}
 
-		Timer* timer = (Timer*)param;
+	bool WindowManager::PreprocessEvent(SDL_Event * e)
+	{
+		++m_eventStats.received;
+		if (!m_coalesceEvents)
+		{
+			return true;
+		}
+
+		if (e->type == SDL_MOUSEMOTION)
+		{
+			CoalesceMotion(e);
+		}
+		else if (e->type >= SDL_USEREVENT && IsSuperseded(e))
+		{
+			++m_eventStats.changesCoalesced;
+			return false;
+		}
+		return true;
+	}
 
-		timerEvent.type = timerEventID;
-		timerEvent.user.code = timer->GetID();
-		timerEvent.user.data1 = timer;
+	void WindowManager::CoalesceMotion(SDL_Event * e)
+	{
+		// Only directly following events, so motion never moves past a click.  Positions
+		// are absolute, the relative motion is accumulated.
+		SDL_Event next;
+		while (SDL_PeepEvents(&next, 1, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) == 1 &&
+			next.type == SDL_MOUSEMOTION &&
+			next.motion.windowID == e->motion.windowID &&
+			next.motion.which == e->motion.which &&
+			next.motion.state == e->motion.state)
+		{
+			SDL_PeepEvents(&next, 1, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION);
+			++m_eventStats.received;
+			++m_eventStats.motionCoalesced;
 
-		SDL_PushEvent(&timerEvent);
-		return(timer->IsOneShot() ? 0 : interval);
+			next.motion.xrel += e->motion.xrel;
+			next.motion.yrel += e->motion.yrel;
+			*e = next;
+		}
+	}
+
+	bool WindowManager::IsSuperseded(const SDL_Event * e)
+	{
+		if (m_changeEvents.find(GetEventKey(e->type, e->user.code)) == m_changeEvents.end())
+		{
+			return false;
+		}
+
+		int count = SDL_PeepEvents(m_peekBuffer, m_peekSize, SDL_PEEKEVENT, e->type, e->type);
+		for (int i = 0; i < count; ++i)
+		{
+			if (m_peekBuffer[i].user.code == e->user.code && m_peekBuffer[i].user.data1 == e->user.data1)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool WindowManager::BubbleEvent(WidgetRef target, SDL_Event * e, const HitResult & hit)
+	{
+		// Parents get the same hit result, the pointer is over their child
+		for (WidgetRef widget = target; widget; widget = widget->GetParent())
+		{
+			PROFILE_SCOPE(PROFILE_EVENT, widget);
+			if (widget->HandleOwnEvent(e, hit))
+			{
+				return true;
+			}
+
+			// Events don't leave the window
+			if (dynamic_cast<WindowRef>(widget))
+			{
+				break;
+			}
+		}
+		return false;
 	}
 
 	Uint32 WindowManager::AddTimer(Uint32 interval, bool oneShot, Widget* owner)
 	{
-		std::unique_ptr<Timer> timer = std::make_unique<Timer>(oneShot, owner);
+		// 0 and -1 are used as 'no timer'
+		while (m_nextTimerID == 0 || m_nextTimerID == (Uint32)-1 || m_timerWheel.Find(m_nextTimerID))
+		{
+			++m_nextTimerID;
+		}
 
-		Uint32 timerID = SDL_AddTimer(interval, timerCallbackFunc, timer.get());
-		timer->SetID(timerID);
+		Timer timer(oneShot, owner);
+		timer.SetID(m_nextTimerID++);
+		m_timerWheel.Add(timer, interval, SDL_GetTicks());
 
-		m_timers.emplace(timerID, std::move(timer));
-		return timerID;
+		if (owner)
+		{
+			owner->m_ownsTimers = true;
+		}
+		return timer.GetID();
 	}
 
 	void WindowManager::DeleteTimer(Uint32 timerID)
 	{
-		if (!SDL_RemoveTimer(timerID))
+		if (!m_timerWheel.Remove(timerID))
 		{
 			throw std::invalid_argument("invalid timer id");
 		}
-		m_timers.erase(timerID);
 	}
 
-	void WindowManager::RaiseSingleWindow(WindowRef win)
+	void WindowManager::RescheduleTimer(Uint32 timerID, Uint32 interval)
 	{
-		const std::string & id = win->GetId();
+		if (!m_timerWheel.Reschedule(timerID, interval, SDL_GetTicks()))
+		{
+			throw std::invalid_argument("invalid timer id");
+		}
+	}
 
-		auto found = std::find_if(m_windows.begin(), m_windows.end(), [id](WindowPtr window) { return window->GetId() == id; });
-		if (found != m_windows.end())
+	void WindowManager::DeleteTimers(Widget* owner)
+	{
+		m_timerWheel.RemoveOwned(owner);
+	}
+
+	void WindowManager::Tick(Uint32 now)
+	{
+		static Uint32 timerEventID = GetEventType(Timer::EventClassName());
+
+		// Handlers may add timers, which could expire in a nested Tick()
+		std::vector<Uint32> expired;
+		expired.swap(m_expiredTimers);
+		expired.clear();
+		m_timerWheel.Advance(now, expired);
+
+		for (Uint32 id : expired)
 		{
-			m_windows.splice(m_windows.end(), m_windows, found);
+			// Deleted by a handler of a timer expired at the same time
+			const Timer * timer = m_timerWheel.Find(id);
+			if (timer == nullptr)
+				continue;
+
+			Widget * owner = timer->GetWidget();
+			bool oneShot = timer->IsOneShot();
+
+			SDL_Event timerEvent;
+			SDL_zero(timerEvent);
+			timerEvent.type = timerEventID;
+			timerEvent.user.code = id;
+			timerEvent.user.data1 = owner;
+
+			if (oneShot)
+			{
+				m_timerWheel.Remove(id);
+			}
+
+			if (owner)
+			{
+				PROFILE_SCOPE(PROFILE_EVENT, owner);
+				owner->HandleEvent(&timerEvent);
+			}
+			else
+			{
+				SDL_PushEvent(&timerEvent);
+			}
 		}
+
+		// Keep the buffer's capacity for the next call
+		m_expiredTimers.swap(expired);
+	}
+
+	void WindowManager::RaiseSingleWindow(WindowRef win)
+	{
+		auto found = m_windowIds.find(win->GetId());
+		if (found == m_windowIds.end() || found->second != win)
+			return;
+
+		m_windows.splice(m_windows.end(), m_windows, win->m_zOrderPos);
+		win->InvalidateGeometry();
 	}
 
 	void WindowManager::RaiseChildren(WindowRef win)
 	{
+		// Children keep their order among themselves
 		RaiseSingleWindow(win);
-		for (auto & child : win->GetChildWindows())
+		for (auto & child : win->m_childWindows)
+		{
+			RaiseChildren(child);
+		}
+	}
+
+	void WindowManager::RaiseAmongSiblings(WindowRef win)
+	{
+		if (!win->HasParent())
+			return;
+
+		auto & siblings = win->GetParentWnd()->m_childWindows;
+		auto pos = std::find(siblings.begin(), siblings.end(), win);
+		if (pos != siblings.end())
 		{
-			RaiseChildren(child.get());
+			std::rotate(pos, pos + 1, siblings.end());
 		}
 	}
 
@@ -278,14 +799,16 @@ namespace CoreUI
 
 		if (win->HasParent())
 		{
+			RaiseAmongSiblings(win->GetParentWnd());
 			RaiseChildren(win->GetParentWnd());
 		}
+		RaiseAmongSiblings(win);
 		RaiseChildren(win);
 	}
 
 	TexturePtr WindowManager::SurfaceToTexture(SDL_Surface* surf)
 	{
-		TexturePtr texture = TexturePtr(SDL_CreateTextureFromSurface(m_renderer, surf), sdl_deleter());
+		TexturePtr texture = MakeTexture(SDL_CreateTextureFromSurface(m_renderer, surf));
 
 		SDL_FreeSurface(surf);
 
@@ -319,8 +842,6 @@ namespace CoreUI
 			}
 			m_registeredEvents[type] = eventId;
 			m_registeredEventsReverse[eventId] = type;
-
-			std::cout << "Register: " << type << ", eventID = " << eventId << std::endl;
 		}		
 		
 		return eventId;
@@ -346,6 +867,8 @@ namespace CoreUI
 		SDL_SetWindowFullscreen(m_window, IsFullscreen() ? 0 : SDL_WINDOW_FULLSCREEN);
 		SDL_ShowCursor(1);
 		PostEvent(EVENT_WINDOWMANAGER_DISPLAYCHANGED);
+		GeometryChanged();
+		Invalidate();
 	}
 
 	ScreenResolution WindowManager::GetScreenResolution() const
@@ -380,6 +903,19 @@ namespace CoreUI
 		PostEvent(EVENT_WINDOWMANAGER_DISPLAYCHANGED);	
 
 		m_windowSize.Clear();
+		GeometryChanged();
+		Invalidate();
+	}
+
+	bool WindowManager::SupportsRenderTargets(RendererRef renderer)
+	{
+		if (renderer != m_targetsRenderer)
+		{
+			SDL_RendererInfo info;
+			m_renderTargets = (SDL_GetRendererInfo(renderer, &info) == 0) && (info.flags & SDL_RENDERER_TARGETTEXTURE);
+			m_targetsRenderer = renderer;
+		}
+		return m_renderTargets;
 	}
 
 	Rect WindowManager::GetWindowSize() const
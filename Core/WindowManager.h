@@ -4,13 +4,18 @@
 #include "Rect.h"
 #include "Point.h"
 #include "Widget.h"
-#include "Timer.h"
+#include "TimerWheel.h"
+#include "Profiler.h"
+#include "Util/SpatialGrid.h"
 #include <string>
 #include <map>
 #include <list>
 #include <functional>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <sstream>
+#include <vector>
 
 namespace CoreUI
 {
@@ -25,6 +30,14 @@ namespace CoreUI
 		Rect Origin;
 	};
 
+	// Events seen by WindowManager::PollEvent during a frame
+	struct DllExport EventStats
+	{
+		uint32_t received = 0; // Taken from the SDL queue
+		uint32_t motionCoalesced = 0; // Mouse motion merged into the next one
+		uint32_t changesCoalesced = 0; // Change notifications dropped for a later identical one
+	};
+
 	struct DllExport ScreenResolution
 	{
 		int id;
@@ -51,8 +64,9 @@ namespace CoreUI
 		using ResolutionList = std::set<ScreenResolution>;
 		using EventMap = std::map<std::string, Uint32>;
 		using ReverseEventMap = std::map<Uint32, std::string>;
-		using TimerList = std::map<Uint32, std::unique_ptr<Timer>>;
 		using WindowList = std::list<WindowPtr>;
+		using WindowIdMap = std::unordered_map<std::string, WindowRef>;
+		using DamageList = std::vector<Rect>;
 
 		virtual ~WindowManager() = default;
 		WindowManager(const WindowManager&) = delete;
@@ -65,7 +79,35 @@ namespace CoreUI
 		void Init(SDL_Window * window, RendererRef renderer);
 		void Dispose();
 
-		void Draw();
+		// Returns false if nothing changed since the last call.  In retained
+		// mode the host can then skip SDL_RenderPresent for this frame.
+		bool Draw();
+
+		// Damage tracking
+		void Invalidate(RectRef rect = nullptr); // nullptr: whole screen
+		void SetRetainedMode(bool retained);
+		bool IsRetainedMode() const { return m_retainedMode; }
+		bool IsDrawing() const { return m_drawing; }
+		uint64_t GetRepaintedPixels() const { return m_repaintedPixels; } // Pixels repainted by last Draw()
+
+		// Frame pacing.  NeedsRedraw() is false while the last frame is still current: no
+		// damage, no queued widget notification.  Call Tick() first, expired timers may
+		// change something.
+		bool NeedsRedraw() const;
+		// Ticks of the next timer expiry (caret blink, tooltips...), false if none
+		bool GetNextDeadline(Uint32 & ticks) const { return m_timerWheel.GetNextExpiry(ticks); }
+		// For SDL_WaitEventTimeout: 0 if a redraw is needed, ms to the next deadline,
+		// or -1 (no timeout) if nothing is scheduled
+		int GetWaitTimeout(Uint32 now = SDL_GetTicks()) const;
+
+		// Controls drawn and skipped as outside their window's visible area by the last Draw()
+		uint32_t GetDrawnControls() const { return m_drawnControls; }
+		uint32_t GetCulledControls() const { return m_culledControls; }
+		void AddControlStats(uint32_t drawn, uint32_t culled) { m_drawnControls += drawn; m_culledControls += culled; }
+
+		// Instrumentation, empty unless built with COREUI_PROFILE (see Profiler)
+		const FrameStats & GetFrameStats() const { return PROFILER().GetLastFrame(); }
+		void SetProfilerOverlay(bool show) { PROFILER().ShowOverlay(show); }
 
 		WindowPtr AddWindow(const char* id, Rect pos, CreationFlags flags = WindowFlags::WIN_DEFAULT);
 		WindowPtr AddWindow(const char* id, WindowPtr parent, Rect pos, CreationFlags flags = WindowFlags::WIN_DEFAULT);
@@ -80,6 +122,33 @@ namespace CoreUI
 		void MoveToFront(WindowRef);
 
 		HitResult HitTest(PointRef);
+
+		// Delivers an event to the widget it concerns: keyboard and text input to the
+		// focused control of the active window, pointer events to the capture owner or
+		// the widget under the pointer.  Unhandled events go up to the parents, up to the
+		// window.  Anything else goes to every window.  Returns true if the event was
+		// handled.
+		bool RouteEvent(SDL_Event *);
+
+		// SDL_PollEvent, with consecutive mouse motion merged into the last one and
+		// change notifications (see Widget::PostChangeEvent) dropped while the same
+		// widget has a later one with the same code queued.
+		bool PollEvent(SDL_Event *);
+		// Same, waiting up to GetWaitTimeout() for an event
+		bool WaitEvent(SDL_Event *);
+		void SetEventCoalescing(bool enable) { m_coalesceEvents = enable; }
+		bool IsEventCoalescing() const { return m_coalesceEvents; }
+		void AddChangeEvent(Uint32 type, EventCode code) { m_changeEvents.insert(GetEventKey(type, code)); }
+		const EventStats & GetEventStats() const { return m_lastEventStats; } // Events polled before the last Draw()
+
+		// Hit tests go through a grid of window and control rects, rebuilt after
+		// geometry changes.  Disable to compare with a plain walk of all windows.
+		void SetHitTestIndex(bool enable) { m_hitTestIndex = enable; }
+		bool IsHitTestIndexed() const { return m_hitTestIndex; }
+
+		// Bumped whenever a window moves, resizes, changes state or z-order
+		void GeometryChanged() { ++m_geometryGeneration; }
+		uint64_t GetGeometryGeneration() const { return m_geometryGeneration; }
 		WindowRef GetActive();
 		void SetActive(WindowRef);
 
@@ -87,8 +156,17 @@ namespace CoreUI
 		const CaptureInfo & GetCapture() const { return m_capture; }
 		void ReleaseCapture() { m_capture.Reset(); }
 
+		// Timers fire from Tick(), on the thread calling it.  The owner gets the timer
+		// event directly, timers without owner post it to the SDL event queue.
 		Uint32 AddTimer(Uint32 interval, bool oneShot = false, Widget* owner = nullptr);
 		void DeleteTimer(Uint32 timerID);
+		void RescheduleTimer(Uint32 timerID, Uint32 interval); // Restarts the timer with a new interval
+		void DeleteTimers(Widget* owner);
+		size_t GetTimerCount() const { return m_timerWheel.GetCount(); }
+
+		// Fires expired timers, each at most once.  Called by Draw(), hosts not
+		// drawing every frame should call it from their event loop.
+		void Tick(Uint32 now = SDL_GetTicks());
 
 		TexturePtr SurfaceToTexture(SDL_Surface * surf);
 
@@ -100,31 +178,81 @@ namespace CoreUI
 		Rect GetWindowSize() const;
 
 		RendererRef GetRenderer() const { return m_renderer; }
+		bool SupportsRenderTargets(RendererRef renderer); // Queried once per renderer
 
 	protected:
 		void PostEvent(EventCode eventCode, void * data1 = nullptr, void * data2 = nullptr);
 
 		Uint32 FindEventType(const char * type) const;
 
+		bool DrawFrame();
+		void DrawWindows(RectRef damage = nullptr); // Skips windows outside 'damage'
+
+		void UpdateHitIndex();
+
+		bool BubbleEvent(WidgetRef target, SDL_Event *, const HitResult & hit);
+
+		static uint64_t GetEventKey(Uint32 type, EventCode code) { return ((uint64_t)type << 32) | (Uint32)code; }
+		bool PreprocessEvent(SDL_Event *); // False if dropped
+		void CoalesceMotion(SDL_Event *);
+		bool IsSuperseded(const SDL_Event *);
+
 		void RaiseSingleWindow(WindowRef);
 		void RaiseChildren(WindowRef);
+		void RaiseAmongSiblings(WindowRef);
 
 		int LoadScreenResolutions();
 
 		WindowManager() : m_renderer(nullptr) {}
 		RendererRef m_renderer;
 		SDL_Window * m_window;
+		RendererRef m_targetsRenderer = nullptr; // Renderer m_renderTargets was queried for
+		bool m_renderTargets = false;
+
+		// Declared before the windows, widgets delete their timers when destroyed
+		TimerWheel m_timerWheel;
+		Uint32 m_nextTimerID = 1;
+		std::vector<Uint32> m_expiredTimers;
 
-		WindowList m_windows;
+		WindowList m_windows; // Z-order, topmost last
+		WindowIdMap m_windowIds;
 		WindowRef m_activeWindow;
 		WindowPtr m_tooltipWindow;
 
 		EventMap m_registeredEvents;
 		ReverseEventMap m_registeredEventsReverse;
-		TimerList m_timers;
+
+		// Event coalescing
+		static const int m_peekSize = 64; // Queued events looked at for a later change notification
+		bool m_coalesceEvents = true;
+		std::unordered_set<uint64_t> m_changeEvents;
+		SDL_Event m_peekBuffer[m_peekSize];
+		EventStats m_eventStats;
+		EventStats m_lastEventStats;
 
 		CaptureInfo m_capture;
 
+		// Damage tracking
+		static const size_t m_maxDamageRects = 8;
+		DamageList m_damage;
+		DamageList m_deferredDamage; // Invalidated while drawing
+		bool m_retainedMode = false;
+		bool m_drawing = false;
+		bool m_frameDrawn = false; // Cleared when the whole frame has to be drawn again
+		TexturePtr m_frameCache;
+		Rect m_frameCacheRect;
+		uint64_t m_repaintedPixels = 0;
+		uint32_t m_drawnControls = 0;
+		uint32_t m_culledControls = 0;
+
+		// Hit testing
+		using HitIndex = SpatialGrid<WindowRef>;
+		bool m_hitTestIndex = true;
+		uint64_t m_geometryGeneration = 0;
+		uint64_t m_hitIndexGeneration = (uint64_t)-1;
+		HitIndex m_hitIndex = HitIndex(128);
+		std::vector<WindowRef> m_hitCandidates;
+
 		mutable Rect m_windowSize;
 		ResolutionList m_screenResolutions;
 	};
@@ -1,59 +1,36 @@
 #pragma once
 #include "Common.h"
 #include "Core/Rect.h"
+#include "Core/ClipStack.h"
 
 namespace CoreUI
 {
+	// Clips drawing to 'rect' for the lifetime of the object, see ClipStack.
+	// Evaluates to false when nothing would be visible: callers skip drawing.
 	class ClipRect
 	{
 	public:
-		ClipRect(RendererRef ren, RectRef rect, bool mergeCurrent = true) : m_renderer(ren)
+		ClipRect(RendererRef ren, RectRef rect, bool mergeCurrent = true)
 		{
-			if (rect == nullptr)
-			{
-				m_clipRect = Rect();
-				SDL_RenderSetClipRect(m_renderer, nullptr);
-				return;
-			}
+			CLIP().Push(ren, rect, mergeCurrent);
+			m_clipRect = CLIP().IsClipped() ? CLIP().GetClip() : Rect();
+			m_empty = CLIP().IsEmpty();
+		}
 
-			SDL_RenderGetClipRect(m_renderer, &m_lastClipRect);
-			if (mergeCurrent && !m_lastClipRect.IsEmpty())
-			{
-				m_clipRect = rect->IntersectRect(&m_lastClipRect);		
-			}
-			else
-			{
-				m_clipRect = *rect;
-			}
+		explicit operator bool() const { return !m_empty; }
 
-#ifdef DEBUG_CLIP
-			SDL_SetRenderDrawColor(m_renderer, 255, m_clipRect.IsEmpty() ? 255 : 0, 0, 255);
-			SDL_RenderDrawRect(m_renderer, &m_clipRect);
-#endif
-			if (m_clipRect.IsEmpty())
-			{
-				SDL_RenderSetClipRect(m_renderer, &Rect(0,0,1,1));
-				
-			}
-			else
-			{
-				SDL_RenderSetClipRect(m_renderer, &m_clipRect);
-			}
-		}
+		static const Rect & GetBaseClip() { return CLIP().GetBaseClip(); }
+		static void SetBaseClip(RectRef rect) { CLIP().SetBaseClip(rect); }
 
-		explicit operator bool() const { return !m_clipRect.IsEmpty(); }
 		RectRef GetClipRegion() { return &m_clipRect; }
-		bool IsClipRegionEmpty() const { return m_clipRect.IsEmpty(); }
+		bool IsClipRegionEmpty() const { return m_empty; }
 
 		~ClipRect()
 		{
-			if (m_lastClipRect.IsEmpty())
-				return;
-			SDL_RenderSetClipRect(m_renderer, &m_lastClipRect);
+			CLIP().Pop();
 		}
 	private:
-		RendererRef m_renderer;
 		Rect m_clipRect;
-		Rect m_lastClipRect;
+		bool m_empty;
 	};
-}
+}
\ No newline at end of file
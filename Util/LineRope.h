@@ -0,0 +1,267 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace CoreUI
+{
+	// Fenwick tree over the sizes of a sequence of blocks, the index of LineRope and
+	// RowRope.  Finds the block holding an item and counts the items before a block in
+	// O(log n).
+	class BlockIndex
+	{
+	public:
+		static const size_t blockSize = 256; // Items per block, a block is split past twice as many
+
+		BlockIndex() : m_topStep(0), m_tree(1, 0) {}
+
+		void Clear()
+		{
+			m_tree.assign(1, 0);
+			m_topStep = 0;
+		}
+
+		// Returns the block holding item 'pos', and sets 'pos' to the offset inside it
+		size_t Find(size_t & pos) const
+		{
+			size_t block = 0;
+			for (size_t step = m_topStep; step; step >>= 1)
+			{
+				if (block + step < m_tree.size() && m_tree[block + step] <= pos)
+				{
+					block += step;
+					pos -= m_tree[block];
+				}
+			}
+			return block;
+		}
+
+		// Items in the blocks before 'block'
+		size_t Prefix(size_t block) const
+		{
+			size_t sum = 0;
+			for (size_t i = block; i > 0; i -= LowBit(i))
+			{
+				sum += m_tree[i];
+			}
+			return sum;
+		}
+
+		void Add(size_t block, ptrdiff_t delta)
+		{
+			for (size_t i = block + 1; i < m_tree.size(); i += LowBit(i))
+			{
+				m_tree[i] += delta;
+			}
+		}
+
+		// Adds an empty block after the last one
+		void AppendBlock()
+		{
+			// New node covers the blocks below it, up to its low bit
+			size_t i = m_tree.size();
+			m_tree.push_back(Prefix(i - 1) - Prefix(i - LowBit(i)));
+			UpdateTopStep();
+		}
+
+		// After blocks are inserted or removed, size(i) returns the size of block i
+		template <typename Size>
+		void Rebuild(size_t blocks, Size size)
+		{
+			m_tree.assign(blocks + 1, 0);
+			for (size_t i = 1; i < m_tree.size(); ++i)
+			{
+				m_tree[i] += size(i - 1);
+				size_t parent = i + LowBit(i);
+				if (parent < m_tree.size())
+				{
+					m_tree[parent] += m_tree[i];
+				}
+			}
+			UpdateTopStep();
+		}
+
+		// Cuts the items of an oversized block in blocks of about blockSize items
+		template <typename T>
+		static std::vector<std::vector<T>> Split(std::vector<T> && items)
+		{
+			size_t count = (items.size() + blockSize - 1) / blockSize;
+			std::vector<std::vector<T>> blocks(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				auto first = items.begin() + (items.size() * i / count);
+				auto last = items.begin() + (items.size() * (i + 1) / count);
+				blocks[i].assign(std::make_move_iterator(first), std::make_move_iterator(last));
+			}
+			items.clear();
+			return blocks;
+		}
+
+	protected:
+		static size_t LowBit(size_t i) { return i & (~i + 1); }
+
+		void UpdateTopStep()
+		{
+			m_topStep = 0;
+			size_t blocks = m_tree.size() - 1;
+			if (blocks)
+			{
+				m_topStep = 1;
+				while (m_topStep * 2 <= blocks)
+				{
+					m_topStep *= 2;
+				}
+			}
+		}
+
+		size_t m_topStep; // Largest power of two <= block count
+		std::vector<size_t> m_tree; // 1-based
+	};
+
+	// Sequence of lines kept in blocks of a few hundred lines.  A Fenwick tree over the
+	// block sizes is the line index: finding, inserting or removing a line costs O(log n)
+	// plus moving the lines of a single block.  Appending at the end never moves lines.
+	template <typename Line>
+	class LineRope
+	{
+	public:
+		LineRope() : m_size(0) {}
+
+		size_t Size() const { return m_size; }
+		bool IsEmpty() const { return m_size == 0; }
+
+		void Clear()
+		{
+			m_blocks.clear();
+			m_index.Clear();
+			m_size = 0;
+		}
+
+		Line & operator[](size_t pos)
+		{
+			size_t block = m_index.Find(pos);
+			return m_blocks[block][pos];
+		}
+
+		const Line & operator[](size_t pos) const
+		{
+			size_t block = m_index.Find(pos);
+			return m_blocks[block][pos];
+		}
+
+		void PushBack(Line line)
+		{
+			if (m_blocks.empty() || m_blocks.back().size() >= BlockIndex::blockSize)
+			{
+				m_blocks.emplace_back();
+				m_index.AppendBlock();
+			}
+
+			m_blocks.back().push_back(std::move(line));
+			m_index.Add(m_blocks.size() - 1, 1);
+			++m_size;
+		}
+
+		// Inserts before 'pos', appends if past the end
+		void Insert(size_t pos, Line line)
+		{
+			if (pos >= m_size)
+			{
+				PushBack(std::move(line));
+				return;
+			}
+
+			size_t block = m_index.Find(pos);
+			Lines & lines = m_blocks[block];
+			lines.insert(lines.begin() + pos, std::move(line));
+			++m_size;
+
+			if (lines.size() > 2 * BlockIndex::blockSize)
+			{
+				std::vector<Lines> blocks = BlockIndex::Split(std::move(lines));
+				m_blocks.erase(m_blocks.begin() + block);
+				m_blocks.insert(m_blocks.begin() + block, std::make_move_iterator(blocks.begin()), std::make_move_iterator(blocks.end()));
+				RebuildIndex();
+			}
+			else
+			{
+				m_index.Add(block, 1);
+			}
+		}
+
+		void Erase(size_t pos, size_t count = 1)
+		{
+			if (pos >= m_size)
+				return;
+
+			count = std::min(count, m_size - pos);
+			m_size -= count;
+
+			// Range starts in 'block' and continues in the following ones
+			bool emptied = false;
+			for (size_t block = m_index.Find(pos); count; ++block, pos = 0)
+			{
+				Lines & lines = m_blocks[block];
+				size_t n = std::min(count, lines.size() - pos);
+				lines.erase(lines.begin() + pos, lines.begin() + pos + n);
+				count -= n;
+
+				if (lines.empty())
+				{
+					emptied = true;
+				}
+				else
+				{
+					m_index.Add(block, -(ptrdiff_t)n);
+				}
+			}
+
+			if (emptied)
+			{
+				m_blocks.erase(std::remove_if(m_blocks.begin(), m_blocks.end(), [](const Lines & lines) { return lines.empty(); }), m_blocks.end());
+				RebuildIndex();
+			}
+		}
+
+		// Calls f(line) for lines in [from, to)
+		template <typename F>
+		void ForEach(size_t from, size_t to, F f) { ForEach(*this, from, to, f); }
+		template <typename F>
+		void ForEach(size_t from, size_t to, F f) const { ForEach(*this, from, to, f); }
+
+		template <typename F>
+		void ForEach(F f) { ForEach(*this, 0, m_size, f); }
+		template <typename F>
+		void ForEach(F f) const { ForEach(*this, 0, m_size, f); }
+
+	protected:
+		using Lines = std::vector<Line>;
+
+		template <typename Self, typename F>
+		static void ForEach(Self & self, size_t from, size_t to, F & f)
+		{
+			to = std::min(to, self.m_size);
+			if (from >= to)
+				return;
+
+			size_t count = to - from;
+			for (size_t block = self.m_index.Find(from); count; ++block, from = 0)
+			{
+				auto & lines = self.m_blocks[block];
+				for (size_t i = from; i < lines.size() && count; ++i, --count)
+				{
+					f(lines[i]);
+				}
+			}
+		}
+
+		void RebuildIndex()
+		{
+			m_index.Rebuild(m_blocks.size(), [this](size_t i) { return m_blocks[i].size(); });
+		}
+
+		size_t m_size;
+		std::vector<Lines> m_blocks;
+		BlockIndex m_index; // Of the block sizes
+	};
+}
\ No newline at end of file
@@ -1,22 +1,27 @@
 #pragma once
 #include "Common.h"
+#include "Core/DrawBatch.h"
+#include "Core/ClipStack.h"
 
 namespace CoreUI
 {
 	class RenderTarget
 	{
 	public:
-		RenderTarget(RendererRef ren, TextureRef texture) : m_renderer(ren)
+		// 'origin': screen position of the texture, see ClipStack::PushTarget
+		RenderTarget(RendererRef ren, TextureRef texture, const Point & origin = Point()) : m_renderer(ren)
 		{
 			if (texture == nullptr)
 			{
 				throw std::invalid_argument("target is null");
 			}
 
+			BATCH().Flush();
 			m_oldTarget = SDL_GetRenderTarget(m_renderer);
 			if (SDL_SetRenderTarget(m_renderer, texture) == 0)
 			{
 				m_target = texture;
+				CLIP().PushTarget(m_renderer, origin);
 			}
 			else
 			{
@@ -32,7 +37,9 @@ namespace CoreUI
 			if (m_target == nullptr)
 				return;
 
+			BATCH().Flush();
 			SDL_SetRenderTarget(m_renderer, m_oldTarget);
+			CLIP().PopTarget();
 		}
 	private:
 		RendererRef m_renderer;
@@ -0,0 +1,219 @@
+#pragma once
+#include "LineRope.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace CoreUI
+{
+	// Where an item sits in a RowRope, kept in the item itself
+	struct RowPosition
+	{
+		struct Block
+		{
+			size_t index = 0; // In the rope's block list
+		};
+
+		RowPosition() = default;
+		RowPosition(Block * block, size_t offset) : block(block), offset(offset) {}
+
+		Block * block = nullptr; // Null when not in the rope
+		size_t offset = 0;
+	};
+
+	// Sequence of items that know their position.  Items are kept in blocks indexed by
+	// a BlockIndex, as in LineRope: finding the item at a row, or the row of an item,
+	// costs O(log n).  Inserting and erasing only renumber the items of the blocks they
+	// touch.
+	//
+	// 'Pos' is the item's RowPosition member, updated by the rope.
+	template <typename Item, RowPosition Item::*Pos>
+	class RowRope
+	{
+	public:
+		static const size_t npos = (size_t)-1;
+
+		RowRope() : m_size(0) {}
+		RowRope(const RowRope&) = delete;
+		RowRope& operator=(const RowRope&) = delete;
+
+		size_t Size() const { return m_size; }
+		bool IsEmpty() const { return m_size == 0; }
+
+		void Clear()
+		{
+			ForEach([](Item * item) { item->*Pos = RowPosition(); });
+			m_blocks.clear();
+			m_index.Clear();
+			m_size = 0;
+		}
+
+		Item * operator[](size_t row) const
+		{
+			size_t block = m_index.Find(row);
+			return m_blocks[block]->items[row];
+		}
+
+		// Row of the item, npos if it isn't in the rope
+		size_t RowOf(const Item * item) const
+		{
+			const RowPosition & pos = item->*Pos;
+			if (pos.block == nullptr)
+				return npos;
+
+			const Block * block = static_cast<const Block*>(pos.block);
+			return m_index.Prefix(block->index) + pos.offset;
+		}
+
+		void PushBack(Item * item)
+		{
+			if (m_blocks.empty() || m_blocks.back()->items.size() >= BlockIndex::blockSize)
+			{
+				m_blocks.emplace_back(new Block());
+				m_blocks.back()->index = m_blocks.size() - 1;
+				m_index.AppendBlock();
+			}
+
+			Block & block = *m_blocks.back();
+			item->*Pos = RowPosition(&block, block.items.size());
+			block.items.push_back(item);
+			m_index.Add(block.index, 1);
+			++m_size;
+		}
+
+		// Inserts [first, last) before 'row', appends if past the end
+		template <typename It>
+		void Insert(size_t row, It first, It last)
+		{
+			if (row >= m_size)
+			{
+				for (; first != last; ++first)
+				{
+					PushBack(*first);
+				}
+				return;
+			}
+
+			size_t index = m_index.Find(row);
+			Block & block = *m_blocks[index];
+			size_t count = block.items.size();
+			block.items.insert(block.items.begin() + row, first, last);
+			count = block.items.size() - count;
+			m_size += count;
+
+			if (block.items.size() > 2 * BlockIndex::blockSize)
+			{
+				Split(index);
+			}
+			else
+			{
+				Renumber(block, row);
+				m_index.Add(index, (ptrdiff_t)count);
+			}
+		}
+
+		void Insert(size_t row, Item * item) { Insert(row, &item, &item + 1); }
+
+		void Erase(size_t row, size_t count = 1)
+		{
+			if (row >= m_size)
+				return;
+
+			count = std::min(count, m_size - row);
+			m_size -= count;
+
+			// Range starts in 'block' and continues in the following ones
+			bool emptied = false;
+			for (size_t index = m_index.Find(row); count; ++index, row = 0)
+			{
+				Block & block = *m_blocks[index];
+				size_t n = std::min(count, block.items.size() - row);
+				for (size_t i = row; i < row + n; ++i)
+				{
+					block.items[i]->*Pos = RowPosition();
+				}
+				block.items.erase(block.items.begin() + row, block.items.begin() + row + n);
+				count -= n;
+
+				if (block.items.empty())
+				{
+					emptied = true;
+				}
+				else
+				{
+					Renumber(block, row);
+					m_index.Add(index, -(ptrdiff_t)n);
+				}
+			}
+
+			if (emptied)
+			{
+				m_blocks.erase(std::remove_if(m_blocks.begin(), m_blocks.end(), [](const BlockPtr & block) { return block->items.empty(); }), m_blocks.end());
+				RebuildIndex();
+			}
+		}
+
+		// Calls f(item) for all items, in order
+		template <typename F>
+		void ForEach(F f) const
+		{
+			for (auto & block : m_blocks)
+			{
+				for (Item * item : block->items)
+				{
+					f(item);
+				}
+			}
+		}
+
+	protected:
+		struct Block : RowPosition::Block
+		{
+			std::vector<Item*> items;
+		};
+		using BlockPtr = std::unique_ptr<Block>;
+
+		// Offsets of the items from 'from' to the end of the block
+		static void Renumber(Block & block, size_t from)
+		{
+			for (size_t i = from; i < block.items.size(); ++i)
+			{
+				block.items[i]->*Pos = RowPosition(&block, i);
+			}
+		}
+
+		// Cuts an oversized block in blocks of about BlockIndex::blockSize items
+		void Split(size_t index)
+		{
+			std::vector<std::vector<Item*>> pieces = BlockIndex::Split(std::move(m_blocks[index]->items));
+			std::vector<BlockPtr> blocks;
+			for (auto & items : pieces)
+			{
+				blocks.emplace_back(new Block());
+				blocks.back()->items = std::move(items);
+			}
+
+			m_blocks.erase(m_blocks.begin() + index);
+			m_blocks.insert(m_blocks.begin() + index, std::make_move_iterator(blocks.begin()), std::make_move_iterator(blocks.end()));
+			for (size_t i = index; i < index + blocks.size(); ++i)
+			{
+				Renumber(*m_blocks[i], 0);
+			}
+			RebuildIndex();
+		}
+
+		void RebuildIndex()
+		{
+			m_index.Rebuild(m_blocks.size(), [this](size_t i) -> size_t
+			{
+				m_blocks[i]->index = i;
+				return m_blocks[i]->items.size();
+			});
+		}
+
+		size_t m_size;
+		std::vector<BlockPtr> m_blocks;
+		BlockIndex m_index; // Of the block sizes
+	};
+}
\ No newline at end of file
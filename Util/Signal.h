@@ -0,0 +1,155 @@
+#pragma once
+#include "Common.h"
+#include "SlotList.h"
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace CoreUI
+{
+	// Connected slots of a signal, shared with its connections so they can disconnect
+	// after the signal is gone
+	class SignalState
+	{
+	public:
+		virtual ~SignalState() = default;
+		virtual void Disconnect(uint32_t id) = 0;
+		virtual bool IsConnected(uint32_t id) const = 0;
+	};
+
+	// Handle to a connected slot.  Copyable, doesn't disconnect by itself.
+	class Connection
+	{
+	public:
+		Connection() = default;
+		Connection(std::weak_ptr<SignalState> state, uint32_t id) : m_state(std::move(state)), m_id(id) {}
+
+		void Disconnect()
+		{
+			if (auto state = m_state.lock())
+			{
+				state->Disconnect(m_id);
+			}
+			m_state.reset();
+		}
+
+		bool IsConnected() const
+		{
+			auto state = m_state.lock();
+			return state && state->IsConnected(m_id);
+		}
+
+	private:
+		std::weak_ptr<SignalState> m_state;
+		uint32_t m_id = 0;
+	};
+
+	// Disconnects its slot when destroyed, i.e. as a member of the object the slot calls
+	class ScopedConnection
+	{
+	public:
+		ScopedConnection() = default;
+		ScopedConnection(Connection connection) : m_connection(std::move(connection)) {}
+		~ScopedConnection() { m_connection.Disconnect(); }
+
+		ScopedConnection(const ScopedConnection&) = delete;
+		ScopedConnection& operator=(const ScopedConnection&) = delete;
+		ScopedConnection(ScopedConnection && rhs) noexcept : m_connection(rhs.Release()) {}
+		ScopedConnection& operator=(ScopedConnection && rhs) noexcept
+		{
+			if (this != &rhs)
+			{
+				m_connection.Disconnect();
+				m_connection = rhs.Release();
+			}
+			return *this;
+		}
+
+		void Disconnect() { m_connection.Disconnect(); }
+		bool IsConnected() const { return m_connection.IsConnected(); }
+
+		// Keeps the slot connected
+		Connection Release()
+		{
+			Connection connection = m_connection;
+			m_connection = Connection();
+			return connection;
+		}
+
+	private:
+		Connection m_connection;
+	};
+
+	// Slots are called directly by Emit(), in connection order.  A slot may connect and
+	// disconnect slots (changes apply to the next emission) and destroy the signal.
+	// Nothing is allocated until the first connection.
+	template <typename... Args>
+	class Signal
+	{
+	public:
+		using Slot = std::function<void(Args...)>;
+
+		Signal() = default;
+		Signal(const Signal&) = delete;
+		Signal& operator=(const Signal&) = delete;
+
+		Connection Connect(Slot slot)
+		{
+			if (!slot)
+			{
+				throw std::invalid_argument("slot is null");
+			}
+
+			if (!m_state)
+			{
+				m_state = std::make_shared<State>();
+			}
+			return Connection(m_state, m_state->Connect(std::move(slot)));
+		}
+
+		void DisconnectAll()
+		{
+			// Connections still referencing the slots see them as disconnected
+			m_state.reset();
+		}
+
+		bool IsEmpty() const { return !m_state || m_state->IsEmpty(); }
+
+		void Emit(Args... args) const
+		{
+			if (!m_state)
+				return;
+
+			// Slots may destroy this signal
+			std::shared_ptr<State> state = m_state;
+			state->Emit(args...);
+		}
+
+	private:
+		class State : public SignalState
+		{
+		public:
+			uint32_t Connect(Slot slot)
+			{
+				uint32_t id = m_nextID++;
+				m_slots.Add(id, std::move(slot));
+				return id;
+			}
+
+			void Disconnect(uint32_t id) override { m_slots.Remove(id); }
+			bool IsConnected(uint32_t id) const override { return m_slots.Contains(id); }
+			bool IsEmpty() const { return m_slots.IsEmpty(); }
+
+			void Emit(Args... args)
+			{
+				m_slots.ForEach([&](Slot & slot) { slot(args...); });
+			}
+
+		private:
+			SlotList<Slot> m_slots;
+			uint32_t m_nextID = 1;
+		};
+
+		std::shared_ptr<State> m_state;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace CoreUI
+{
+	// Callbacks identified by an id, called in order by ForEach().  A callback may add
+	// and remove entries of the list it is called from: added entries wait until the
+	// outermost ForEach() returns, removed ones are skipped and erased then.
+	template <typename Entry>
+	class SlotList
+	{
+	public:
+		void Add(uint32_t id, Entry entry)
+		{
+			if (m_calling)
+			{
+				m_pending.push_back({ id, std::move(entry), true });
+			}
+			else
+			{
+				m_slots.push_back({ id, std::move(entry), true });
+			}
+		}
+
+		// Returns false if the id isn't in the list
+		bool Remove(uint32_t id)
+		{
+			for (Slots * list : { &m_slots, &m_pending })
+			{
+				for (auto it = list->begin(); it != list->end(); ++it)
+				{
+					if (it->id != id || !it->active)
+						continue;
+
+					if (m_calling)
+					{
+						// The entry may be running, erased after the call
+						it->active = false;
+						m_removed = true;
+					}
+					else
+					{
+						list->erase(it);
+					}
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool Contains(uint32_t id) const
+		{
+			for (const Slots * list : { &m_slots, &m_pending })
+			{
+				for (const Slot & slot : *list)
+				{
+					if (slot.id == id)
+						return slot.active;
+				}
+			}
+			return false;
+		}
+
+		bool IsEmpty() const { return m_slots.empty() && m_pending.empty(); }
+
+		// Calls f(entry) for the entries in the list when the outermost call started
+		template <typename F>
+		void ForEach(F f)
+		{
+			++m_calling;
+
+			// Entries added meanwhile are in m_pending, the list doesn't grow
+			for (size_t i = 0; i < m_slots.size(); ++i)
+			{
+				if (m_slots[i].active)
+				{
+					f(m_slots[i].entry);
+				}
+			}
+
+			if (--m_calling == 0)
+			{
+				Compact();
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			uint32_t id;
+			Entry entry;
+			bool active; // Cleared when removed during ForEach()
+		};
+		using Slots = std::vector<Slot>;
+
+		void Compact()
+		{
+			if (m_removed)
+			{
+				m_slots.erase(std::remove_if(m_slots.begin(), m_slots.end(),
+					[](const Slot & slot) { return !slot.active; }), m_slots.end());
+				m_removed = false;
+			}
+
+			for (Slot & slot : m_pending)
+			{
+				if (slot.active)
+				{
+					m_slots.push_back(std::move(slot));
+				}
+			}
+			m_pending.clear();
+		}
+
+		Slots m_slots;
+		Slots m_pending; // Added during ForEach()
+		int m_calling = 0;
+		bool m_removed = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+#include "Common.h"
+#include "Core/Rect.h"
+#include "Core/Point.h"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace CoreUI
+{
+	// Uniform grid of square cells, each listing the items whose rect overlaps it.
+	// Finding the items under a point only looks at one cell.  Items covering too many
+	// cells are kept in a separate list checked on every query.
+	//
+	// Queries return items in insertion order.
+	template <typename T>
+	class SpatialGrid
+	{
+	public:
+		explicit SpatialGrid(int cellSize = 64, size_t maxCells = 256) : m_cellSize(cellSize), m_maxCells(maxCells) {}
+
+		void Clear()
+		{
+			m_entries.clear();
+			m_cells.clear();
+			m_large.clear();
+		}
+
+		bool IsEmpty() const { return m_entries.empty(); }
+
+		void Insert(const Rect & rect, T item)
+		{
+			if (rect.w <= 0 || rect.h <= 0)
+				return;
+
+			size_t index = m_entries.size();
+			m_entries.push_back({ rect, std::move(item) });
+
+			int x1 = CellPos(rect.x);
+			int y1 = CellPos(rect.y);
+			int x2 = CellPos(rect.x + rect.w - 1);
+			int y2 = CellPos(rect.y + rect.h - 1);
+
+			if ((size_t)(x2 - x1 + 1) * (size_t)(y2 - y1 + 1) > m_maxCells)
+			{
+				m_large.push_back(index);
+				return;
+			}
+
+			for (int y = y1; y <= y2; ++y)
+			{
+				for (int x = x1; x <= x2; ++x)
+				{
+					m_cells[CellKey(x, y)].push_back(index);
+				}
+			}
+		}
+
+		// Appends the items containing any of the points, each item once
+		void Query(const Point * pts, size_t count, std::vector<T> & out) const
+		{
+			m_found.clear();
+			for (size_t i = 0; i < count; ++i)
+			{
+				Point pt = pts[i];
+				auto cell = m_cells.find(CellKey(CellPos(pt.x), CellPos(pt.y)));
+				if (cell != m_cells.end())
+				{
+					AddFound(cell->second, pt);
+				}
+				AddFound(m_large, pt);
+			}
+
+			std::sort(m_found.begin(), m_found.end());
+			m_found.erase(std::unique(m_found.begin(), m_found.end()), m_found.end());
+			for (size_t index : m_found)
+			{
+				out.push_back(m_entries[index].item);
+			}
+		}
+
+		void Query(const Point & pt, std::vector<T> & out) const { Query(&pt, 1, out); }
+
+	protected:
+		struct Entry
+		{
+			Rect rect;
+			T item;
+		};
+		using IndexList = std::vector<size_t>;
+
+		int CellPos(int pos) const
+		{
+			// Round toward negative infinity
+			return (pos >= 0) ? (pos / m_cellSize) : -((m_cellSize - 1 - pos) / m_cellSize);
+		}
+
+		static uint64_t CellKey(int x, int y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+		void AddFound(const IndexList & indices, const Point & pt) const
+		{
+			for (size_t index : indices)
+			{
+				const Rect & rect = m_entries[index].rect;
+				if (pt.x >= rect.x && pt.x < rect.x + rect.w && pt.y >= rect.y && pt.y < rect.y + rect.h)
+				{
+					m_found.push_back(index);
+				}
+			}
+		}
+
+		int m_cellSize;
+		size_t m_maxCells;
+
+		std::vector<Entry> m_entries;
+		std::unordered_map<uint64_t, IndexList> m_cells;
+		IndexList m_large;
+
+		mutable IndexList m_found; // Query scratch buffer
+	};
+}
\ No newline at end of file
@@ -44,11 +44,16 @@ namespace CoreUI
 
 	bool Button::HandleEvent(SDL_Event *e)
 	{
-		if (Widget::HandleEvent(e))
+		Point pt(e->button.x, e->button.y);
+		return HandleOwnEvent(e, HitTest(&pt));
+	}
+
+	bool Button::HandleOwnEvent(SDL_Event *e, const HitResult & hit)
+	{
+		if (HandleTooltip(e, &hit))
 			return true;
 
 		Point pt(e->button.x, e->button.y);
-		HitResult hit = HitTest(&pt);
 		const CaptureInfo & capture = WINMGR().GetCapture();
 		switch (e->type)
 		{
@@ -57,19 +62,19 @@ namespace CoreUI
 			{
 				SetActive();
 				SetFocus(this);
-				m_pushed = true;
+				SetPushed(true);
 				WINMGR().StartCapture(hit, &pt);
 				return true;
 			}
 			break;
 		case SDL_MOUSEBUTTONUP:
-			m_pushed = false;
+			SetPushed(false);
 			if (capture && capture.Target.target == this)
 			{
 				WINMGR().ReleaseCapture();
 				if (hit.target == this)
 				{
-					PostEvent(EVENT_BUTTON_CLICKED);
+					Clicked();
 				}
 			}
 			return true;
@@ -81,7 +86,7 @@ namespace CoreUI
 
 			if (capture && capture.Target.target == this)
 			{
-				m_pushed = (hit.target == this);
+				SetPushed(hit.target == this);
 			}
 			break;
 		case SDL_KEYDOWN:
@@ -91,24 +96,32 @@ namespace CoreUI
 				{
 				case SDLK_SPACE:
 				case SDLK_RETURN:				
-					m_pushed = true;
+					SetPushed(true);
 					WINMGR().StartCapture(HitResult(HIT_CLIENT, this), &pt);
 					return true;
 				}
 			}
 			break;
 		case SDL_KEYUP:
-			m_pushed = false;
+			SetPushed(false);
 			if (capture && capture.Target.target == this)
 			{
 				WINMGR().ReleaseCapture();
-				PostEvent(EVENT_BUTTON_CLICKED);
+				Clicked();
 			}
 			return true;
 		}
 		return false;
 	}
 
+	void Button::Clicked()
+	{
+		PostEvent(EVENT_BUTTON_CLICKED);
+
+		// Last, a slot may remove the button
+		m_onClicked.Emit(this);
+	}
+
 	HitResult Button::HitTest(const PointRef pt)
 	{
 		Rect parent = m_parent->GetClientRect(false, true);
@@ -136,7 +149,6 @@ namespace CoreUI
 
 		if (m_label)
 		{
-			m_label->SetBorder(IsFocused());
 			m_label->Draw(&drawRect.Deflate(m_borderWidth));
 		}
 	}
@@ -158,7 +170,6 @@ namespace CoreUI
 		{	
 			Rect target = m_label->GetRect(true, false).CenterInTarget(&drawRect, false, true);
 
-			m_label->SetBorder(IsFocused());
 			m_label->Draw(&target);
 		}
 	}
@@ -169,6 +180,25 @@ namespace CoreUI
 		CreateLabel();		
 	}
 
+	// The label's border shows the focus
+	void Button::SetFocus(WidgetRef focus, WidgetRef parent)
+	{
+		Widget::SetFocus(focus, parent);
+		if (m_label)
+		{
+			m_label->SetBorder(IsFocused());
+		}
+	}
+
+	void Button::ClearFocus()
+	{
+		Widget::ClearFocus();
+		if (m_label)
+		{
+			m_label->SetBorder(false);
+		}
+	}
+
 	void Button::CreateLabel()
 	{
 		if (m_flags & WIN_AUTOSIZE)
@@ -184,7 +214,7 @@ namespace CoreUI
 		m_label->SetPadding(0);
 		m_label->SetBorderColor(Color::C_MED_GREY);
 		m_label->SetBorderWidth(1);
-		m_label->SetBorder(true);
+		m_label->SetBorder(IsFocused());
 		m_label->SetParent(this);
 		m_label->Init();
 		UpdateButtonSize();
@@ -214,7 +244,13 @@ namespace CoreUI
 			height = std::max(height, labelRect.h);
 		}
 
-		m_rect = Rect(0, 0, width + (2*m_borderWidth), height + (2*m_borderWidth));
+		Rect rect(0, 0, width + (2*m_borderWidth), height + (2*m_borderWidth));
+		if (!rect.IsEqual(&m_rect))
+		{
+			InvalidateGeometry();
+			m_rect = rect;
+			InvalidateGeometry();
+		}
 	}
 	struct Button::shared_enabler : public Button
 	{
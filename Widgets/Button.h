@@ -4,6 +4,7 @@
 #include "Core/Rect.h"
 #include "Core/Color.h"
 #include "Core/WindowManager.h"
+#include "Util/Signal.h"
 #include <string>
 #include <vector>
 
@@ -36,21 +37,30 @@ namespace CoreUI
 		Rect GetClientRect(bool relative = true, bool scrolled = true) const override;
 
 		bool HandleEvent(SDL_Event *) override;
+		bool HandleOwnEvent(SDL_Event *, const HitResult &) override;
 		HitResult HitTest(const PointRef) override;
 		void Draw() override;
 		void Draw(RectRef);
 
 		void SetText(const char *) override;
+		void SetFocus(WidgetRef focus, WidgetRef parent = nullptr) override;
+		void ClearFocus() override;
 
-		void SetPushed(bool pushed) { m_pushed = pushed; }
+		void SetPushed(bool pushed) { if (pushed != m_pushed) { m_pushed = pushed; Invalidate(); } }
+
+		// Called as soon as the button is clicked, EVENT_BUTTON_CLICKED is still posted
+		Signal<ButtonRef> & OnClicked() { return m_onClicked; }
 
 	protected:
 		Button(const char* id, RendererRef renderer, Rect rect, const char* label, ImageRef image, FontRef font, CreationFlags flags);
 
 		void UpdateButtonSize();
 		void CreateLabel();
+		void Clicked();
+
 		LabelPtr m_label;
 		bool m_pushed;
+		Signal<ButtonRef> m_onClicked;
 
 		struct shared_enabler;
 	};
@@ -2,6 +2,9 @@
 #include <SDL.h>
 #include <SDL_image.h>
 #include "Image.h"
+#include "Core/DrawBatch.h"
+#include "Core/Profiler.h"
+#include "Core/ClipStack.h"
 #include "ResourceMap.h"
 #include "Util/PlatformResource.h"
 
@@ -45,7 +48,7 @@ namespace CoreUI
 
 	bool Image::LoadFromFile(const char* fileName)
 	{
-		m_texture = TexturePtr(IMG_LoadTexture(m_renderer, fileName), sdl_deleter());
+		m_texture = MakeTexture(IMG_LoadTexture(m_renderer, fileName));
 		if (m_texture)
 		{
 			SDL_QueryTexture(m_texture.get(), NULL, NULL, &m_rect.w, &m_rect.h);
@@ -66,7 +69,7 @@ namespace CoreUI
 			return false;
 		}
 
-		m_texture = TexturePtr(IMG_LoadTexture_RW(m_renderer, SDL_RWFromConstMem(resource.data, resource.size), 0), sdl_deleter());
+		m_texture = MakeTexture(IMG_LoadTexture_RW(m_renderer, SDL_RWFromConstMem(resource.data, resource.size), 0));
 		if (m_texture)
 		{
 			SDL_QueryTexture(m_texture.get(), NULL, NULL, &m_rect.w, &m_rect.h);
@@ -109,9 +112,11 @@ namespace CoreUI
 	void Image::Draw(const PointRef pos)
 	{
 		Rect target = Rect(pos->x, pos->y, m_rect.w, m_rect.h);
-		if (m_texture && m_renderer)
+		if (m_texture && m_renderer && CLIP().IsVisible(target))
 		{
-			SDL_RenderCopy(m_renderer, m_texture.get(), &m_rect, &target);
+			BATCH().Flush();
+			PROFILE_COUNT(renderCopies);
+			SDL_RenderCopy(m_renderer, m_texture.get(), &m_rect, &CLIP().ToTarget(target));
 		}
 	}
 	
@@ -155,7 +160,12 @@ namespace CoreUI
 				target.y += rect->h - source.h;
 			}
 
-			SDL_RenderCopy(m_renderer, m_texture.get(), &source, &target);
+			if (!CLIP().IsVisible(target))
+				return;
+
+			BATCH().Flush();
+			PROFILE_COUNT(renderCopies);
+			SDL_RenderCopy(m_renderer, m_texture.get(), &source, &CLIP().ToTarget(target));
 		}
 	}
 
@@ -5,7 +5,6 @@
 #include "Core/ResourceManager.h"
 #include "Core/Window.h"
 #include "Util/ClipRect.h"
-#include "Util/RenderTarget.h"
 #include "Image.h"
 #include "Label.h"
 #include <algorithm>
@@ -31,17 +30,6 @@ namespace CoreUI
 		RenderLabel();
 	}
 
-	void Label::SetForegroundColor(Color color)
-	{
-		bool colorChanged = (color != m_foregroundColor);
-		Widget::SetForegroundColor(color);
-
-		if (colorChanged)
-		{
-			RenderLabel();
-		}
-	}
-
 	LabelPtr Label::CreateSingle(const char * id, RendererRef renderer, Rect rect, const char * label, FontRef font, TextAlign align, CreationFlags flags)
 	{
 		auto ptr = std::make_shared<shared_enabler>(id, renderer, rect, label, font, align, 0 | flags);
@@ -150,7 +138,7 @@ namespace CoreUI
 
 	void Label::DrawLabel(RectRef rect)
 	{
-		if (m_labelText)
+		if (!m_labelText.empty())
 		{
 			bool hCenter = (m_labelAlign & TEXT_H_CENTER) == TEXT_H_CENTER;
 			bool vCenter = (m_labelAlign & TEXT_V_CENTER) == TEXT_V_CENTER;
@@ -196,7 +184,18 @@ namespace CoreUI
 				target.y += GetShrinkFactor().h;
 			}
 
-			SDL_RenderCopy(m_renderer, m_labelText.get(), &source, &target);
+			// Source offset is the part of the text cut on the left/top
+			Point origin(target.x - source.x, target.y - source.y);
+			RES().GetGlyphAtlas().DrawText(m_font, m_labelText.c_str(), &origin, m_foregroundColor, &target);
+
+			if (!m_underline.IsEmpty())
+			{
+				Rect underline = m_underline.Offset(&origin).IntersectRect(&target);
+				if (!underline.IsEmpty())
+				{
+					DrawFilledRect(&underline, m_foregroundColor);
+				}
+			}
 		}
 	}
 
@@ -208,71 +207,33 @@ namespace CoreUI
 
 	void Label::RenderLabel()
 	{
-		size_t underlinePos = -1;
-		std::string toRender = m_text;
-		if (m_flags & LCF_MENUITEM)
-		{
-			toRender = RemoveAmpersands(underlinePos);
-		}
+		size_t underlinePos = std::string::npos;
+		m_labelText = (m_flags & LCF_MENUITEM) ? RemoveAmpersands(underlinePos) : m_text;
 
-		SDL_Surface* label;
-		if (toRender.find('\n') == std::string::npos)
-		{
-			 label = TTF_RenderText_Blended(m_font, toRender.c_str(), m_foregroundColor);
-		}
-		else
-		{
-			label = TTF_RenderText_Blended_Wrapped(m_font, toRender.c_str(), m_foregroundColor, 0);
-		}
+		// Glyphs come from the shared atlas, only the layout is computed here
+		GlyphAtlas & atlas = RES().GetGlyphAtlas();
+		Point size = atlas.GetTextSize(m_font, m_labelText.c_str());
+		m_labelRect = Rect(0, 0, size.x, size.y);
 
-		m_labelText = SurfaceToTexture(label);
-
-		SDL_QueryTexture(m_labelText.get(), NULL, NULL, &m_labelRect.w, &m_labelRect.h);
-		m_labelRect.x = 0;
-		m_labelRect.y = 0;
-		
-		if ((m_flags & LCF_MENUITEM) && (underlinePos != std::string::npos))
+		m_underline.Clear();
+		if ((m_flags & LCF_MENUITEM) && (underlinePos < m_labelText.size()))
 		{
-			DrawUnderline(toRender, underlinePos);
+			int width = 16;
+			TTF_GlyphMetrics(m_font, (uint8_t)m_labelText[underlinePos], nullptr, &width, nullptr, nullptr, nullptr);
+
+			m_underline = Rect(atlas.GetTextWidth(m_font, m_labelText.c_str(), underlinePos), m_labelRect.h - 2, width + 1, 1);
 		}
 
 		if (m_flags & WIN_AUTOSIZE)
 		{
 			m_rect.w = m_labelRect.w + (2 * GetShrinkFactor().w);
 			m_rect.h = m_labelRect.h + (2 * GetShrinkFactor().h);
-		}
-	}
-
-	void Label::DrawUnderline(const std::string & str, const size_t & underlinePos)
-	{
-		int xPos = 0;
-		if (underlinePos > 0)
-		{
-			TTF_SizeText(m_font, str.substr(0, underlinePos).c_str(), &xPos, nullptr);
-		}
-		int width = 16;
-		TTF_GlyphMetrics(m_font, str[underlinePos], nullptr, &width, nullptr, nullptr, nullptr);
-
-		// Texture from fonts are not writable
-		TexturePtr clone = CloneTexture(m_labelText);
-		if (clone)
-		{
-			RenderTarget target(m_renderer, clone.get());
-			if (target)
-			{
-				SetDrawColor(m_foregroundColor);
-				SDL_RenderDrawLine(m_renderer, xPos, m_labelRect.h - 2, xPos + width, m_labelRect.h - 2);
-				m_labelText = std::move(clone);
-			}
-			else
+			if (m_parent)
 			{
-				std::cerr << "Unable to set render target" << std::endl;
+				m_parent->ChildGeometryChanged(this);
 			}
 		}
-		else
-		{
-			std::cerr << "Unable to set clone texture" << std::endl;
-		}
+		Invalidate();
 	}
 
 	void Label::SetAlign(uint8_t align)
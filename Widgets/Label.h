@@ -49,8 +49,6 @@ namespace CoreUI
 		// Auto-size, draw at desired position with Draw(Rect)
 		static LabelPtr CreateAutoSize(const char* id, RendererRef renderer, const char* label, FontRef font = nullptr, TextAlign align = TEXT_AUTOSIZE_DEFAULT, CreationFlags flags = 0);
 
-		void SetForegroundColor(Color color) override;
-
 		void Draw() override;
 		void Draw(const RectRef rect, bool noClip = false);
 
@@ -65,13 +63,13 @@ namespace CoreUI
 		void DrawBackground(const CoreUI::RectRef &rect);
 		Rect DrawFrame(const CoreUI::RectRef &rect);
 		void RenderLabel();
-		void DrawUnderline(const std::string &str, const size_t &underlinePos);
 		void DrawLabel(RectRef rect);
 
 		std::string RemoveAmpersands(size_t & underlinePos); // Returns updated string, position of first ampersand in underlinePos, -1 if not found
 
-		TexturePtr m_labelText;
+		std::string m_labelText; // Text as drawn, without ampersands
 		Rect m_labelRect;
+		Rect m_underline; // Relative to label origin, empty if none
 		TextAlign m_labelAlign;
 
 		struct shared_enabler;
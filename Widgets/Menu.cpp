@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include <SDL.h>
 #include "Util/ClipRect.h"
+#include "Core/DrawBatch.h"
+#include "Core/Profiler.h"
 #include "Menu.h"
 #include "Label.h"
 #include "MenuItem.h"
@@ -129,8 +131,7 @@ namespace CoreUI
 		}
 
 		// "erase" space between label and menu
-		SetDrawColor(m_backgroundColor);
-		SDL_RenderDrawLine(m_renderer, labelRect.x + 1, labelRect.y + m_lineHeight - 1, labelRect.x + labelRect.w - 2, labelRect.y + m_lineHeight - 1);
+		DrawLine(labelRect.x + 1, labelRect.y + m_lineHeight - 1, labelRect.x + labelRect.w - 2, labelRect.y + m_lineHeight - 1, m_backgroundColor);
 	}
 
 	void Menu::DrawActiveFrame(MenuItemRef item)
@@ -139,7 +140,12 @@ namespace CoreUI
 		if (parent)
 		{
 			Rect highlight = item->m_rect.Offset(&parent->m_renderedMenuRect.Origin());
-			SDL_RenderCopy(m_renderer, parent->m_renderedActiveMenu.get(), &item->m_rect, &highlight);
+			if (CLIP().IsVisible(highlight))
+			{
+				BATCH().Flush();
+				PROFILE_COUNT(renderCopies);
+				SDL_RenderCopy(m_renderer, parent->m_renderedActiveMenu.get(), &item->m_rect, &CLIP().ToTarget(highlight));
+			}
 
 			DrawActiveFrame(parent);
 		}
@@ -158,6 +164,7 @@ namespace CoreUI
 		m_lineHeight = item->m_label->GetRect(true, false).h;
 
 		m_items.push_back(item);
+		WINMGR().GeometryChanged(); // Menu bar height
 
 		if (hotkey != SDLK_UNKNOWN)
 		{
@@ -246,7 +253,7 @@ namespace CoreUI
 				WINMGR().ReleaseCapture();
 				if (item && hit == HIT_MENU_ITEM)
 				{
-					PostEvent(EVENT_MENU_SELECTED, item.get());
+					Selected(item.get());
 				}
 				// Eat the click anyway so user doesn't accidentally activate a control outside the menu area
 				return true;
@@ -289,9 +296,10 @@ namespace CoreUI
 				case SDLK_RETURN:
 					if (m_active)
 					{
+						MenuItemRef item = m_active;
 						WINMGR().ReleaseCapture();
-						PostEvent(EVENT_MENU_SELECTED, m_active);
 						CloseMenu();
+						Selected(item);
 						return true;
 					}
 				}
@@ -333,8 +341,9 @@ namespace CoreUI
 						}
 						else
 						{
-							PostEvent(EVENT_MENU_SELECTED, m_active);
+							MenuItemRef item = m_active;
 							CloseMenu();
+							Selected(item);
 						}
 
 						return true;
@@ -380,6 +389,7 @@ namespace CoreUI
 		}
 
 		item->m_opened = true;
+		Invalidate();
 	}
 
 	void Menu::CloseMenuItem(MenuItemRef item)
@@ -398,8 +408,26 @@ namespace CoreUI
 		}
 	}
 
+	void Menu::Invalidate()
+	{
+		if (m_parent)
+		{
+			m_parent->ChildInvalidated();
+		}
+		WINMGR().Invalidate();
+	}
+
+	void Menu::Selected(MenuItemRef item)
+	{
+		PostEvent(EVENT_MENU_SELECTED, item);
+
+		// Last, a slot may remove the menu
+		m_onSelected.Emit(item);
+	}
+
 	void Menu::CloseMenu()
 	{
+		Invalidate();
 		m_active = nullptr;
 		for (auto & item : m_items)
 		{
@@ -430,6 +458,8 @@ namespace CoreUI
 		if (!m_active)
 			return;
 
+		Invalidate();
+
 		// Top level
 		if (m_active->GetParentMenuItem() == nullptr)
 		{
@@ -460,6 +490,8 @@ namespace CoreUI
 		if (!m_active)
 			return;
 
+		Invalidate();
+
 		// Top level, move left right
 		if (m_active->GetParentMenuItem() == nullptr)
 		{
@@ -490,6 +522,8 @@ namespace CoreUI
 		if (!m_active)
 			return;
 
+		Invalidate();
+
 		MenuItemRef parent = m_active->GetParentMenuItem();
 		if (parent == nullptr)
 		{
@@ -522,6 +556,8 @@ namespace CoreUI
 		if (!m_active)
 			return;
 
+		Invalidate();
+
 		MenuItemRef parent = m_active->GetParentMenuItem();
 		if (parent == nullptr)
 		{ 
@@ -3,6 +3,7 @@
 #include "Core/Widget.h"
 #include "Core/Rect.h"
 #include "Core/Point.h"
+#include "Util/Signal.h"
 #include <string>
 #include <vector>
 
@@ -39,6 +40,8 @@ namespace CoreUI
 		void Draw() override {};
 		void Draw(const RectRef);
 
+		void Invalidate() override; // Opened menus can overlap anything
+
 		void OpenMenu(MenuItemRef item);
 		void CloseMenu();
 
@@ -49,6 +52,9 @@ namespace CoreUI
 		void MoveUp();
 		void MoveDown();
 
+		// Called as soon as an item is selected, EVENT_MENU_SELECTED is still posted
+		Signal<MenuItemRef> & OnSelected() { return m_onSelected; }
+
 	protected:
 		Menu(RendererRef renderer, const char * id);
 
@@ -57,6 +63,7 @@ namespace CoreUI
 		void DrawActiveFrame(MenuItemRef parent);
 		void DrawOpenedMenu(MenuItemPtr & item);
 		void CloseMenuItem(MenuItemRef item);
+		void Selected(MenuItemRef item);
 
 		MenuItems::const_iterator FindMenuItem(MenuItemRef item, MenuItemRef parent = nullptr) const;
 
@@ -64,6 +71,7 @@ namespace CoreUI
 		int m_lineHeight;
 		MenuItems m_items;
 		HotkeyMap m_hotkeys;
+		Signal<MenuItemRef> m_onSelected;
 
 		struct shared_enabler;
 	};
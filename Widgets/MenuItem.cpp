@@ -4,6 +4,8 @@
 #include "Label.h"
 #include "Image.h"
 #include "Util/RenderTarget.h"
+#include "Core/Profiler.h"
+#include "Core/ClipStack.h"
 
 #define MENUICONSIZE 16
 
@@ -59,7 +61,12 @@ namespace CoreUI
 		{
 			m_renderedMenuRect.x = pos->x;
 			m_renderedMenuRect.y = pos->y;
-			SDL_RenderCopy(m_renderer, m_renderedMenu.get(), nullptr, &m_renderedMenuRect);
+			if (CLIP().IsVisible(m_renderedMenuRect))
+			{
+				BATCH().Flush();
+				PROFILE_COUNT(renderCopies);
+				SDL_RenderCopy(m_renderer, m_renderedMenu.get(), nullptr, &CLIP().ToTarget(m_renderedMenuRect));
+			}
 
 			if (HasSubMenu())
 			{
@@ -266,11 +273,11 @@ namespace CoreUI
 
 				if (active)
 				{
-					m_renderedActiveMenu = TexturePtr(texture, sdl_deleter());
+					m_renderedActiveMenu = MakeTexture(texture);
 				}
 				else
 				{
-					m_renderedMenu = TexturePtr(texture, sdl_deleter());
+					m_renderedMenu = MakeTexture(texture);
 				}
 				
 			}
@@ -101,47 +101,51 @@ namespace CoreUI
 		DrawButton(&m_scrollState.vSlider, Color::C_LIGHT_GREY, nullptr, !m_parent->GetPushedState(HIT_VSCROLL_SLIDER));
 	}
 
-	void ScrollBars::CheckChildScrollStatus(WidgetRef child, RectRef thisRect, bool &showH, bool &showV)
+	void ScrollBars::UpdateContentSize()
 	{
-		Rect parentRect = child->GetParent()->GetClientRect(true);
+		m_contentSize = Point();
+		auto extend = [this](const Rect & rect)
+		{
+			m_contentSize.x = std::max(m_contentSize.x, rect.x + rect.w);
+			m_contentSize.y = std::max(m_contentSize.y, rect.y + rect.h);
+		};
 
-		if (((thisRect->x + thisRect->w) > parentRect.w))
+		for (auto & child : m_parent->GetChildWindowRefs())
 		{
-			showH = true;
-			int hMax = ((thisRect->x + thisRect->w) - parentRect.w);
-			m_scrollState.hMax = std::max(m_scrollState.hMax, hMax);
+			if (!(child->GetShowState() & (WST_MAXIMIZED | WST_MINIMIZED)))
+			{
+				extend(child->GetRect(true, false));
+			}
 		}
-
-		if ((thisRect->y + thisRect->h) > parentRect.h)
+		for (auto & child : m_parent->GetControls())
 		{
-			showV = true;		
-			int vMax = ((thisRect->y + thisRect->h) - parentRect.h);
-			m_scrollState.vMax = std::max(m_scrollState.vMax, vMax);
+			extend(child->GetRect(true, false));
 		}
+		m_contentDirty = false;
 	}
 
 	void ScrollBars::RefreshScrollBarStatus()
 	{
-		m_scrollState.hMax = 0;
-		m_scrollState.vMax = 0;
-
-		bool showH = false;
-		bool showV = false;
-		for (auto & child : m_parent->GetChildWindows())
+		// Children only change the content size when they report it
+		if (m_contentDirty)
 		{
-			if (child->GetParent() != nullptr && !(child->GetShowState() & (WST_MAXIMIZED | WST_MINIMIZED)))
-			{
-				Rect childRect = child->GetRect(true, false);
-				CheckChildScrollStatus(child.get(), &childRect, showH, showV);
-			}
+			UpdateContentSize();
 		}
-		for (auto & child : m_parent->GetControls())
+
+		Rect parentRect = m_parent->GetClientRect(true);
+		m_scrollState.hMax = std::max(0, m_contentSize.x - parentRect.w);
+		m_scrollState.vMax = std::max(0, m_contentSize.y - parentRect.h);
+
+		bool showH = (m_scrollState.hMax > 0) || m_parent->m_scrollPos.x;
+		bool showV = (m_scrollState.vMax > 0) || m_parent->m_scrollPos.y;
+
+		// Showing or hiding a bar resizes the client area
+		if (showH != m_scrollState.showH || showV != m_scrollState.showV)
 		{
-			CheckChildScrollStatus(child.second.get(), &child.second->GetRect(true, false), showH, showV);
+			m_scrollState.showH = showH;
+			m_scrollState.showV = showV;
+			WINMGR().GeometryChanged();
 		}
-
-		m_scrollState.showH = showH || m_parent->m_scrollPos.x;
-		m_scrollState.showV = showV || m_parent->m_scrollPos.y;
 	}
 
 	void ScrollBars::Draw(RectRef pos)
@@ -232,15 +236,17 @@ namespace CoreUI
 		if (m_parent->GetFlags() & WindowFlags::WIN_NOSCROLL)
 			return;
 
+		Point pos = m_parent->m_scrollPos;
 		if (m_scrollState.showH)
 		{
-			m_parent->m_scrollPos.x = clip(m_parent->m_scrollPos.x + pt->x, 0, m_scrollState.hMax);
+			pos.x = clip(pos.x + pt->x, 0, m_scrollState.hMax);
 		}
 
 		if (m_scrollState.showV)
 		{
-			m_parent->m_scrollPos.y = clip(m_parent->m_scrollPos.y + pt->y, 0, m_scrollState.vMax);
+			pos.y = clip(pos.y + pt->y, 0, m_scrollState.vMax);
 		}
+		SetScrollPos(pos);
 	}
 
 	void ScrollBars::ScrollTo(PointRef pt)
@@ -248,20 +254,31 @@ namespace CoreUI
 		if (m_parent->GetFlags() & WindowFlags::WIN_NOSCROLL)
 			return;
 
-		m_parent->m_scrollPos.x = clip(pt->x, 0, m_scrollState.hMax);
-		m_parent->m_scrollPos.y = clip(pt->y, 0, m_scrollState.vMax);
+		SetScrollPos(Point(clip(pt->x, 0, m_scrollState.hMax), clip(pt->y, 0, m_scrollState.vMax)));
 	}
 
 	void ScrollBars::ClickHScrollBar(PointRef pt)
 	{
 		int rel = (pt->x - m_scrollState.hScrollArea.x) * m_scrollState.hMax / m_scrollState.hScrollArea.w;
-		m_parent->m_scrollPos.x = clip(rel, 0, m_scrollState.hMax);
+		SetScrollPos(Point(clip(rel, 0, m_scrollState.hMax), m_parent->m_scrollPos.y));
 	}
 
 	void ScrollBars::ClickVScrollBar(PointRef pt)
 	{
 		int rel = (pt->y - m_scrollState.vScrollArea.y) * m_scrollState.vMax / m_scrollState.vScrollArea.h;
-		m_parent->m_scrollPos.y = clip(rel, 0, m_scrollState.vMax);
+		SetScrollPos(Point(m_parent->m_scrollPos.x, clip(rel, 0, m_scrollState.vMax)));
+	}
+
+	void ScrollBars::SetScrollPos(Point pos)
+	{
+		if (!pos.IsEqual(&m_parent->m_scrollPos))
+		{
+			m_parent->m_scrollPos = pos;
+			m_parent->Invalidate();
+
+			// Child windows and controls moved
+			WINMGR().GeometryChanged();
+		}
 	}
 
 	bool ScrollBars::HandleEvent(SDL_Event * e)
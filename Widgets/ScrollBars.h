@@ -38,6 +38,7 @@ namespace CoreUI
 		void Draw(RectRef pos);
 
 		void RefreshScrollBarStatus();
+		void ContentChanged() { m_contentDirty = true; } // A child window or control moved or resized
 		void ScrollRel(PointRef pt);
 		void ScrollTo(PointRef pt);
 		void ClickHScrollBar(PointRef pt);
@@ -49,7 +50,8 @@ namespace CoreUI
 	protected:
 		ScrollBars(RendererRef renderer, WindowRef parent);
 
-		void CheckChildScrollStatus(WidgetRef child, RectRef rect, bool &showH, bool &showV);
+		void UpdateContentSize();
+		void SetScrollPos(Point pos); // Invalidates parent window on change
 
 		
 		void DrawHScrollBar(RectRef pos);
@@ -60,6 +62,10 @@ namespace CoreUI
 		WindowRef m_parent;
 		ScrollState m_scrollState;
 
+		// Bottom right corner of the children, relative to the unscrolled client area
+		Point m_contentSize;
+		bool m_contentDirty = true;
+
 		struct shared_enabler;
 	};
 }
\ No newline at end of file
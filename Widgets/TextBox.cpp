@@ -8,8 +8,8 @@
 #include "TextBox.h"
 #include "Image.h"
 #include <algorithm>
-#include <sstream>
 #include <cassert>
+#include <cstring>
 
 #ifndef INT_MAX
 #define INT_MAX       2147483647    // maximum (signed) int value
@@ -18,11 +18,9 @@
 
 namespace CoreUI
 {
-	Uint32 TextBox::m_blinkTimerID = (Uint32)-1;
-
 	TextBox::TextBox(const char * id, RendererRef renderer, Rect rect, const char * text, CreationFlags flags) :
 		Widget(id, renderer, nullptr, rect, text, nullptr, RES().FindFont("mono"), flags), 
-		m_blink(true), m_xOffset(0), m_lineWidth(-1)
+		m_blink(true), m_xOffset(0), m_lineWidth(-1), m_maxLines(0)
 	{
 		m_backgroundColor = Color::C_WHITE;
 		m_borderColor = Color::C_BLACK;
@@ -37,7 +35,7 @@ namespace CoreUI
 		m_lineHeight = TTF_FontLineSkip(m_font);
 		if (TTF_FontFaceIsFixedWidth(m_font))
 		{
-			TTF_SizeText(m_font, "X", &m_charWidth, nullptr);
+			m_charWidth = RES().GetGlyphAtlas().GetTextWidth(m_font, "X");
 		}
 		else
 		{
@@ -45,9 +43,25 @@ namespace CoreUI
 		}
 
 		RenderText();
-		if (m_blinkTimerID == (Uint32)-1)
+	}
+
+	void TextBox::SetFocus(WidgetRef focus, WidgetRef parent)
+	{
+		Widget::SetFocus(focus, parent);
+		if (IsFocused() && m_blinkTimerID == (Uint32)-1)
+		{
+			m_blink = true;
+			m_blinkTimerID = WINMGR().AddTimer(530, false, this);
+		}
+	}
+
+	void TextBox::ClearFocus()
+	{
+		Widget::ClearFocus();
+		if (m_blinkTimerID != (Uint32)-1)
 		{
-			m_blinkTimerID = WINMGR().AddTimer(530);
+			WINMGR().DeleteTimer(m_blinkTimerID);
+			m_blinkTimerID = (Uint32)-1;
 		}
 	}
 
@@ -122,7 +136,7 @@ namespace CoreUI
 				DrawCursor(&drawRect);
 			}
 
-			DrawText(&drawRect);
+			DrawText(&drawRect, clip.GetClipRegion());
 		}
 	}
 
@@ -140,34 +154,35 @@ namespace CoreUI
 		if (m_blink && (WINMGR().GetActive() == m_parent))
 		{
 			int xPos = rect->x + m_caretPos.x - m_xOffset;
-			SetDrawColor(Color::C_DARK_GREY);
-			SDL_RenderDrawLine(m_renderer, xPos, yPos, xPos, yPos + m_lineHeight);
-			SDL_RenderDrawLine(m_renderer, xPos+1, yPos, xPos+1, yPos + m_lineHeight);
+			DrawFilledRect(&Rect(xPos, yPos, 2, m_lineHeight + 1), Color::C_DARK_GREY);
 		}
 	}
 
-	void TextBox::DrawText(RectRef rect)
+	void TextBox::DrawText(RectRef rect, RectRef clip)
 	{
-		for (size_t i = 0; i<m_lines.size(); ++i)
-		{
-			auto & line = m_lines[i];
+		// Only the lines crossing the clip region
+		int first = std::max(0, (clip->y - rect->y) / m_lineHeight);
+		int last = (clip->y + clip->h - rect->y + m_lineHeight - 1) / m_lineHeight;
 
-			Rect target = { rect->x, rect->y + ((int)i*m_lineHeight), line.rect.w, line.rect.h };
+		GlyphAtlas & atlas = RES().GetGlyphAtlas();
+		int i = first;
+		m_lines.ForEach(first, std::max(first, last), [&](const TextLine & line)
+		{
+			Point origin(rect->x, rect->y + (i++ * m_lineHeight));
+			if (line.text.empty())
+				return;
 
-			Rect source = line.rect;
-			
-			if (!(m_flags & WIN_FILL))
+			if (m_flags & WIN_FILL)
 			{
-				target.w = std::min(rect->w, source.w);
-				source.x += m_xOffset;
-				source.w = target.w;
+				atlas.DrawText(m_font, line.text.c_str(), &origin, m_foregroundColor);
 			}
-
-			if (line.texture)
+			else
 			{
-				SDL_RenderCopy(m_renderer, line.texture.get(), &source, &target);
+				Rect target = { origin.x, origin.y, std::min(rect->w, line.rect.w), line.rect.h };
+				origin.x -= m_xOffset;
+				atlas.DrawText(m_font, line.text.c_str(), &origin, m_foregroundColor, &target);
 			}
-		}
+		});
 	}
 
 	void TextBox::DrawBackground(const RectRef &rect)
@@ -181,83 +196,168 @@ namespace CoreUI
 
 	void TextBox::SetText(const char * text)
 	{
-		Widget::SetText(text);
+		// m_text is stale once edited, always replaces the lines
+		m_text = text ? text : "";
 		RenderText();
+		Invalidate();
 	}
 
 	std::string TextBox::GetText() const
 	{
-		std::ostringstream os;
-		std::string delim = "";
-		for (auto & line : m_lines)
+		size_t size = m_lines.IsEmpty() ? 0 : m_lines.Size() - 1;
+		m_lines.ForEach([&size](const TextLine & line) { size += line.text.size(); });
+
+		std::string text;
+		text.reserve(size);
+
+		bool first = true;
+		m_lines.ForEach([&](const TextLine & line)
 		{
-			os << delim << line.text;
-			delim = "\n";
-		}
-		return os.str();
+			if (!first)
+			{
+				text += '\n';
+			}
+			text += line.text;
+			first = false;
+		});
+		return text;
+	}
+
+	void TextBox::WriteText(std::ostream & os) const
+	{
+		bool first = true;
+		m_lines.ForEach([&](const TextLine & line)
+		{
+			if (!first)
+			{
+				os << '\n';
+			}
+			os.write(line.text.data(), line.text.size());
+			first = false;
+		});
 	}
 
 	void TextBox::RenderText()
 	{
+		// New text or font
+		ReleasePositions();
 		SplitLines();
 		RenderLines();
 	}
 
 	void TextBox::SplitLines()
 	{
-		std::stringstream ss(m_text);
 		size_t currLine = 0;
-		while (ss.good())
+		size_t begin = 0;
+		while (begin <= m_text.size())
 		{
-			std::string line;
-			std::getline(ss, line);
+			size_t end = m_text.find('\n', begin);
+			if (end == std::string::npos)
+			{
+				end = m_text.size();
+			}
+			std::string line = m_text.substr(begin, end - begin);
+			begin = end + 1;
 
-			if (m_lines.size() < currLine + 1)
+			if (m_lines.Size() < currLine + 1)
 			{
-				m_lines.push_back(line);
+				TextLine newLine(std::move(line));
+				AddLine(newLine);
+				m_lines.PushBack(std::move(newLine));
 			}
 			else // Act only if line changed
 			{
-				if (m_lines[currLine] != line)
+				TextLine & curr = m_lines[currLine];
+				if (curr != line)
 				{
-					m_lines[currLine] = line;
+					SetLineText(curr, std::move(line));
 				}
 			}
 			++currLine;
 		}
 
-		if (currLine < m_lines.size())
-		{
-			m_lines.resize(currLine);
-		}
+		m_lines.ForEach(currLine, m_lines.Size(), [this](const TextLine & line) { RemoveLine(line); });
+		m_lines.Erase(currLine, m_lines.Size() - currLine);
 	}
 
-	void TextBox::RenderLines()
+	void TextBox::MeasureLine(TextLine & line)
 	{
-		int maxWidth = 0;
-		if (m_font == nullptr)
+		int width = line.text.empty() ? 0 : RES().GetGlyphAtlas().GetTextWidth(m_font, line.text.c_str());
+		line.rect = Rect(0, 0, width, TTF_FontHeight(m_font));
+	}
+
+	void TextBox::AddLine(TextLine & line)
+	{
+		MeasureLine(line);
+		++m_lineWidths[line.rect.w];
+	}
+
+	void TextBox::RemoveLine(const TextLine & line)
+	{
+		auto it = m_lineWidths.find(line.rect.w);
+		if (it != m_lineWidths.end() && --it->second == 0)
 		{
-			throw std::invalid_argument("TextBox: No Font");
+			m_lineWidths.erase(it);
 		}
+	}
+
+	void TextBox::SetLineText(TextLine & line, std::string text)
+	{
+		RemoveLine(line);
+		line.text = std::move(text);
+		line.positionsID = 0;
+		AddLine(line);
+	}
 
-		for (auto & line : m_lines)
+	const std::vector<int> & TextBox::GetPositions(TextLine & line)
+	{
+		++m_positionsClock;
+		LinePositions * oldest = &m_positions[0];
+		for (LinePositions & entry : m_positions)
 		{
-			if (!line.texture && !line.text.empty())
+			if (line.positionsID && entry.id == line.positionsID)
+			{
+				entry.used = m_positionsClock;
+				return entry.positions;
+			}
+			if (entry.used < oldest->used)
 			{
-				SDL_Surface* surface = TTF_RenderText_Blended(m_font, line.text.c_str(), m_foregroundColor);
-				line.texture = SurfaceToTexture(surface);
-				SDL_QueryTexture(line.texture.get(), NULL, NULL, &line.rect.w, &line.rect.h);
+				oldest = &entry;
 			}
+		}
 
-			maxWidth = std::max(maxWidth, line.rect.w);
+		// The line loses its positions if they get evicted, lines moving in m_lines don't matter
+		oldest->id = line.positionsID = m_nextPositionsID++;
+		oldest->used = m_positionsClock;
+		RES().GetGlyphAtlas().GetTextPositions(m_font, line.text.c_str(), oldest->positions);
+		return oldest->positions;
+	}
+
+	void TextBox::ReleasePositions()
+	{
+		for (LinePositions & entry : m_positions)
+		{
+			entry = LinePositions();
 		}
+	}
+
+	void TextBox::RenderLines()
+	{
+		if (m_font == nullptr)
+		{
+			throw std::invalid_argument("TextBox: No Font");
+		}
+
+		// Lines are drawn as they come into view, only the size is updated here
+		int maxWidth = m_lineWidths.empty() ? 0 : m_lineWidths.rbegin()->first;
 		
 		if (m_flags & WIN_FILL)
 		{
-			Rect newRect = { 0, 0, maxWidth + (2 * GetShrinkFactor().w), (int)m_lines.size() * TTF_FontLineSkip(m_font) + (2 * GetShrinkFactor().h) };
+			Rect newRect = { 0, 0, maxWidth + (2 * GetShrinkFactor().w), (int)m_lines.Size() * TTF_FontLineSkip(m_font) + (2 * GetShrinkFactor().h) };
 			if (!newRect.IsEqual(&m_rect))
 			{
 				m_rect = newRect;
+				m_parent->ChildGeometryChanged(this);
 				GetParentWnd()->GetScrollBars()->RefreshScrollBarStatus();
 			}
 		}
@@ -279,20 +379,144 @@ namespace CoreUI
 				m_lineWidth = maxWidth;
 			}
 		}
+		Invalidate();
 	}
 
 	void TextBox::InsertLine(const char * text, size_t at)
 	{
-		if (at > m_lines.size() - 1)
+		TextLine line(text);
+		AddLine(line);
+		m_lines.Insert(at, std::move(line));
+		RenderLines();
+		PostChangeEvent(EVENT_TEXTBOX_CHANGED);
+	}
+
+	void TextBox::Append(const char * const * lines, size_t count)
+	{
+		if (lines == nullptr || count == 0)
+			return;
+
+		bool pinned = IsPinnedToBottom();
+
+		// Skip what tail mode would drop right away
+		if (m_maxLines && count > m_maxLines)
 		{
-			m_lines.push_back(text);
+			lines += count - m_maxLines;
+			count = m_maxLines;
 		}
-		else
+
+		for (size_t i = 0; i < count; ++i)
 		{
-			m_lines.insert(m_lines.begin() + at, text);
+			TextLine line(lines[i]);
+			AddLine(line);
+			m_lines.PushBack(std::move(line));
 		}
+
+		EndAppend(pinned);
+	}
+
+	void TextBox::AppendText(const char * text)
+	{
+		if (text == nullptr || *text == '\0')
+			return;
+
+		bool pinned = IsPinnedToBottom();
+
+		if (m_lines.IsEmpty())
+		{
+			TextLine line;
+			AddLine(line);
+			m_lines.PushBack(std::move(line));
+		}
+
+		// Up to the first '\n' continues the last line
+		const char * end = strchr(text, '\n');
+		size_t len = end ? (size_t)(end - text) : strlen(text);
+		if (len)
+		{
+			TextLine & last = m_lines[m_lines.Size() - 1];
+			SetLineText(last, last.text + std::string(text, len));
+		}
+
+		while (end)
+		{
+			text = end + 1;
+			end = strchr(text, '\n');
+			len = end ? (size_t)(end - text) : strlen(text);
+
+			TextLine line(std::string(text, len));
+			AddLine(line);
+			m_lines.PushBack(std::move(line));
+		}
+
+		EndAppend(pinned);
+	}
+
+	void TextBox::SetMaxLines(size_t maxLines)
+	{
+		m_maxLines = maxLines;
+		if (TrimLines())
+		{
+			RenderLines();
+			PostChangeEvent(EVENT_TEXTBOX_CHANGED);
+		}
+	}
+
+	bool TextBox::IsPinnedToBottom()
+	{
+		WindowRef parentWnd = GetParentWnd();
+		if (!(m_flags & WIN_FILL) || parentWnd == nullptr)
+			return false;
+
+		ScrollStateRef state = parentWnd->GetScrollBars()->GetScrollState();
+		return !state->showV || (parentWnd->GetScrollPos()->y >= state->vMax);
+	}
+
+	void TextBox::EndAppend(bool pinned)
+	{
+		size_t dropped = TrimLines();
 		RenderLines();
-		PostEvent(EVENT_TEXTBOX_CHANGED);
+
+		WindowRef parentWnd = GetParentWnd();
+		if ((m_flags & WIN_FILL) && parentWnd)
+		{
+			ScrollBarsRef scrollBars = parentWnd->GetScrollBars();
+			if (pinned)
+			{
+				scrollBars->ScrollTo(&Point(parentWnd->GetScrollPos()->x, scrollBars->GetScrollState()->vMax));
+			}
+			else if (dropped)
+			{
+				// Keep the same lines in view
+				scrollBars->ScrollRel(&Point(0, -(int)dropped * m_lineHeight));
+			}
+		}
+
+		PostChangeEvent(EVENT_TEXTBOX_CHANGED);
+	}
+
+	size_t TextBox::TrimLines()
+	{
+		if (m_maxLines == 0 || m_lines.Size() <= m_maxLines)
+			return 0;
+
+		size_t dropped = m_lines.Size() - m_maxLines;
+		m_lines.ForEach(0, dropped, [this](const TextLine & line) { RemoveLine(line); });
+		m_lines.Erase(0, dropped);
+
+		// Caret stays on the same line, or goes to the top if that line is gone
+		if (m_currentPos.y < (int)dropped)
+		{
+			m_currentPos = Point(0, 0);
+			m_caretPos = Point(0, 0);
+		}
+		else
+		{
+			m_currentPos.y -= (int)dropped;
+			m_caretPos.y = m_currentPos.y * m_lineHeight;
+		}
+
+		return dropped;
 	}
 
 	void TextBox::InsertAt(const char * text, size_t line, size_t col)
@@ -300,19 +524,18 @@ namespace CoreUI
 		if (text == nullptr)
 			return;
 
-		if (m_lines.size() == 0)
+		if (m_lines.IsEmpty())
 		{
 			InsertLine(text);
 		}
 		else
 		{
-			line = std::min(m_lines.size() - 1, line);
-			std::string s = m_lines[line].text;
-			col = std::min(s.length(), col);
-			s.insert(col, text);
-			m_lines[line] = s;
+			line = std::min(m_lines.Size() - 1, line);
+			TextLine & curr = m_lines[line];
+			col = std::min(curr.text.length(), col);
+			SetLineText(curr, std::string(curr.text).insert(col, text));
 			RenderLines();
-			PostEvent(EVENT_TEXTBOX_CHANGED);
+			PostChangeEvent(EVENT_TEXTBOX_CHANGED);
 		}
 	}
 
@@ -327,31 +550,28 @@ namespace CoreUI
 
 	void TextBox::DeleteLine(size_t line)
 	{
-		line = std::min(m_lines.size() - 1, line);
-		m_lines.erase(m_lines.begin() + line);
-		PostEvent(EVENT_TEXTBOX_CHANGED);
+		line = std::min(m_lines.Size() - 1, line);
+		RemoveLine(m_lines[line]);
+		m_lines.Erase(line);
+		Invalidate();
+		PostChangeEvent(EVENT_TEXTBOX_CHANGED);
 	}
 
 	void TextBox::MoveCursor(int x, int y)
 	{
-		m_currentPos.x = std::max(0, x);
-		m_currentPos.y = std::max(0, y);
+		y = clip(y, 0, (int)m_lines.Size() - 1);
 
-		m_currentPos.y = std::min((int)m_lines.size() - 1, m_currentPos.y);
-		m_currentPos.x = std::min((int)m_lines[m_currentPos.y].text.length(), m_currentPos.x);
+		TextLine & line = m_lines[y];
+		const std::vector<int> & positions = GetPositions(line);
 
-		m_caretPos.y = m_currentPos.y * m_lineHeight;	
-		if (m_currentPos.x == 0)
-		{
-			m_caretPos.x = 0;
-		}
-		else
-		{
-			std::string subStr = m_lines[m_currentPos.y].text.substr(0, m_currentPos.x);
-			TTF_SizeText(m_font, subStr.c_str(), &m_caretPos.x, nullptr);
-		}
+		m_currentPos.y = y;
+		m_currentPos.x = clip(x, 0, (int)positions.size() - 1);
+
+		m_caretPos.y = m_currentPos.y * m_lineHeight;
+		m_caretPos.x = positions[m_currentPos.x];
 
 		ScrollCursorIntoView();
+		Invalidate();
 	}
 
 	void TextBox::MoveCursorRel(int16_t deltaX, int16_t deltaY)
@@ -363,44 +583,14 @@ namespace CoreUI
 	{	
 		if (m_flags & WIN_FILL)
 		{
-			const std::string &toSplit = m_lines[m_currentPos.y].text;
-			std::string endPart = toSplit.substr(m_currentPos.x);
-			m_lines[m_currentPos.y] = toSplit.substr(0, m_currentPos.x);
+			TextLine & toSplit = m_lines[m_currentPos.y];
+			std::string endPart = toSplit.text.substr(m_currentPos.x);
+			SetLineText(toSplit, toSplit.text.substr(0, m_currentPos.x));
 			InsertLine(endPart.c_str(), m_currentPos.y + 1); // RenderLines();
 			MoveCursorRel(INT16_MIN, 1);
 		}
 	}
 
-	// For proportial fonts
-	int TextBox::FindStringPos(const std::string & in, int pos, int len, int fraction)
-	{		
-		if (len <= 0)
-		{
-			return 0;
-		}
-
-		std::string subStr = in.substr(0, len);
-
-		int width;
-		TTF_SizeText(m_font, subStr.c_str(), &width, nullptr);
-
-		if (fraction == 1)
-		{
-			return (pos < width) ? len - 1 : len;
-		}
-
-		if (pos < width)
-		{
-			len -= (fraction+1) / 2;
-			return FindStringPos(in, pos, len, (fraction+1)/2);
-		}
-		else 
-		{
-			len += (fraction+1) / 2;
-			return FindStringPos(in, pos, len, (fraction+1)/2);
-		}
-	}
-
 	void TextBox::ScrollCursorIntoView()
 	{	
 		if (m_flags & WIN_FILL)
@@ -493,7 +683,7 @@ namespace CoreUI
 		Point rel(pt->x + m_xOffset - client.x, pt->y - client.y);
 
 		cursorPos.y = (rel.y / m_lineHeight);
-		if (cursorPos.y > (int)(m_lines.size() - 1))
+		if (cursorPos.y > (int)(m_lines.Size() - 1))
 		{
 			return Point(0, INT_MAX);
 		}
@@ -508,19 +698,11 @@ namespace CoreUI
 		{
 			cursorPos.x = INT_MAX;
 		}
-		else if (line.text.size() == 1)
-		{
-			cursorPos.x = 0;
-		}
-		else if (m_charWidth > 0)
-		{
-			// Fixed fonts
-			cursorPos.x = (rel.x+1) / m_charWidth;
-		}
 		else
 		{
-			// Proportial fonts
-			cursorPos.x = FindStringPos(line.text, rel.x, (int)line.text.size(), (int)line.text.size());
+			// Character under the point
+			const std::vector<int> & positions = GetPositions(line);
+			cursorPos.x = (int)(std::upper_bound(positions.begin(), positions.end(), rel.x) - positions.begin()) - 1;
 		}
 
 		MoveCursor(cursorPos.x, cursorPos.y);
@@ -539,25 +721,25 @@ namespace CoreUI
 			TextLine &currLine = m_lines[m_currentPos.y];
 			size_t prevX = prevLine.text.size();
 
-			prevLine = prevLine.text + currLine.text;
+			SetLineText(prevLine, prevLine.text + currLine.text);
 			DeleteLine(m_currentPos.y);
 			RenderLines();
 			MoveCursor((int)prevX, m_currentPos.y - 1);
 		}
 		else // Normal case
 		{
-			m_lines[m_currentPos.y].text.erase(m_currentPos.x-1, 1);
-			m_lines[m_currentPos.y].texture = nullptr;
+			TextLine & currLine = m_lines[m_currentPos.y];
+			SetLineText(currLine, std::string(currLine.text).erase(m_currentPos.x - 1, 1));
 			RenderLines();
 			MoveCursorRel(-1, 0);
-			PostEvent(EVENT_TEXTBOX_CHANGED);
+			PostChangeEvent(EVENT_TEXTBOX_CHANGED);
 		}		
 	}
 
 	void TextBox::Delete()
 	{
 		TextLine &currLine = m_lines[m_currentPos.y];
-		if (m_currentPos.y == (int)(m_lines.size() - 1) && 
+		if (m_currentPos.y == (int)(m_lines.Size() - 1) && 
 			m_currentPos.x == (int)currLine.text.size())
 			return;
 
@@ -567,14 +749,13 @@ namespace CoreUI
 			TextLine &nextLine = m_lines[m_currentPos.y + 1];
 			TextLine &currLine = m_lines[m_currentPos.y];
 
-			currLine = currLine.text + nextLine.text;
+			SetLineText(currLine, currLine.text + nextLine.text);
 			DeleteLine(m_currentPos.y + 1);
 		}
 		else // Normal case
 		{
-			m_lines[m_currentPos.y].text.erase(m_currentPos.x, 1);
-			m_lines[m_currentPos.y].texture = nullptr;
-			PostEvent(EVENT_TEXTBOX_CHANGED);
+			SetLineText(currLine, std::string(currLine.text).erase(m_currentPos.x, 1));
+			PostChangeEvent(EVENT_TEXTBOX_CHANGED);
 		}
 
 		RenderLines();
@@ -607,17 +788,23 @@ namespace CoreUI
 	}
 
 	bool TextBox::HandleEvent(SDL_Event *e)
+	{
+		Point pt(e->button.x, e->button.y);
+		return HandleOwnEvent(e, HitTest(&pt));
+	}
+
+	bool TextBox::HandleOwnEvent(SDL_Event *e, const HitResult & hit)
 	{
 		static Uint32 timerEventID = WINMGR().GetEventType(Timer::EventClassName());
 
 		Point pt(e->button.x, e->button.y);
-		HitResult hit = HitTest(&pt);
 
 		if (e->type == timerEventID)
 		{
 			if ((Uint32)e->user.code == m_blinkTimerID && IsFocused())
 			{
 				m_blink = !m_blink;
+				Invalidate();
 			}
 			return false;
 		}
@@ -3,6 +3,9 @@
 #include "Core/Widget.h"
 #include "Core/Rect.h"
 #include "Core/WindowManager.h"
+#include "Util/LineRope.h"
+#include <map>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -33,11 +36,17 @@ namespace CoreUI
 		static TextBoxPtr CreateFill(const char* id, RendererRef renderer, const char* text);
 
 		bool HandleEvent(SDL_Event *) override;
+		bool HandleOwnEvent(SDL_Event *, const HitResult &) override;
 		HitResult HitTest(const PointRef) override;
 		void Draw() override;
 
+		// The caret blinks only while focused, an idle text box doesn't wake up the host
+		void SetFocus(WidgetRef focus, WidgetRef parent = nullptr) override;
+		void ClearFocus() override;
+
 		void SetText(const char *) override;
 		std::string GetText() const override;
+		void WriteText(std::ostream & os) const; // Same as GetText, without building the whole string
 
 		void MoveCursor(int x, int y);
 		void MoveCursorRel(int16_t deltaX, int16_t deltaY);
@@ -45,6 +54,16 @@ namespace CoreUI
 		void InsertAt(const char * text, size_t line = std::numeric_limits<size_t>::max(), size_t col = std::numeric_limits<size_t>::max());
 		void InsertLine(const char * text = nullptr, size_t at = std::numeric_limits<size_t>::max());
 		void DeleteLine(size_t at);
+
+		// Adds lines at the end with a single change event.  If the view was scrolled
+		// to the bottom it follows the new lines.
+		void Append(const char * const * lines, size_t count);
+		// Adds to the end of the last line, '\n' starts a new line (i.e. streamed output)
+		void AppendText(const char * text);
+
+		// Tail mode: only the last 'maxLines' lines are kept, 0 for no limit
+		void SetMaxLines(size_t maxLines);
+		size_t GetMaxLines() const { return m_maxLines; }
 		void Backspace();
 		void Delete();
 		void Return();
@@ -62,10 +81,21 @@ namespace CoreUI
 			const bool operator!=(const std::string& rhs) const { return text != rhs; }
 
 			std::string text;
-			TexturePtr texture;
-			Rect rect;
+			Rect rect; // Size of the text
+			uint32_t positionsID = 0; // Entry of m_positions for this text, 0 if none
 		};
-		using TextLines = std::vector<TextLine>;
+
+		// x position of each character and of the end, for the last lines the caret or a
+		// click visited.  The least recently used entry is reused, keeping its capacity.
+		struct LinePositions
+		{
+			uint32_t id = 0;
+			uint32_t used = 0;
+			std::vector<int> positions;
+		};
+		static const size_t m_maxPositionLines = 16;
+		using TextLines = LineRope<TextLine>;
+		using LineWidths = std::map<int, size_t>; // Number of lines of each width
 
 		TextBox(const char* id, RendererRef renderer, Rect rect, const char* text, CreationFlags flags);
 		WindowRef GetParentWnd() { return dynamic_cast<WindowRef>(m_parent); }
@@ -73,18 +103,31 @@ namespace CoreUI
 		void RenderText();
 		void SplitLines();
 		void RenderLines();
-		void DrawText(RectRef rect);
+		void DrawText(RectRef rect, RectRef clip);
 		Rect DrawFrame(const CoreUI::RectRef &rect);
 		void DrawBackground(const CoreUI::RectRef &rect);
 		void DrawCursor(RectRef rect);
 
-		int FindStringPos(const std::string & in, int pos, int len, int fraction);
+		// Line widths are kept for all lines, from font metrics
+		void MeasureLine(TextLine & line);
+		void AddLine(TextLine & line);
+		void RemoveLine(const TextLine & line);
+		void SetLineText(TextLine & line, std::string text);
+
+		const std::vector<int> & GetPositions(TextLine & line);
+		void ReleasePositions();
 		int GetLineWidth(); // Single line mode
 
+		bool IsPinnedToBottom();
+		void EndAppend(bool pinned);
+		size_t TrimLines();
+
 		void ScrollCursorIntoView();
 		void ScrollX(int fieldWidth, int16_t offset);
 
 		TextLines m_lines;
+		LineWidths m_lineWidths;
+		size_t m_maxLines;
 		int m_lineHeight;
 		int m_charWidth;
 		Rect m_textRect;
@@ -96,7 +139,11 @@ namespace CoreUI
 		Point m_currentPos;
 		Point m_caretPos;
 
-		static Uint32 m_blinkTimerID;
+		LinePositions m_positions[m_maxPositionLines];
+		uint32_t m_nextPositionsID = 1;
+		uint32_t m_positionsClock = 0;
+
+		Uint32 m_blinkTimerID = (Uint32)-1;
 		bool m_blink;
 
 		struct shared_enabler;
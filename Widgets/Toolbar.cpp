@@ -97,6 +97,10 @@ namespace CoreUI
 		ToolbarItemPtr item = ToolbarItem::Create(id, m_renderer, name, image);
 		item->SetParent(this);
 		item->Init();
+
+		// Items are buttons, their clicks are forwarded as long as the toolbar exists
+		ToolbarItemRef itemRef = item.get();
+		m_itemConnections.emplace_back(item->OnClicked().Connect([this, itemRef](ButtonRef) { ItemClicked(itemRef); }));
 		
 		m_items.push_back(item);
 
@@ -111,6 +115,12 @@ namespace CoreUI
 			[id](ToolbarItemPtr it) { return it && it->GetId() == id; });
 	}
 
+	void Toolbar::ItemClicked(ToolbarItemRef item)
+	{
+		PostEvent(EVENT_TOOLBAR_CLICKED, item);
+		m_onClicked.Emit(item);
+	}
+
 	void Toolbar::AddSeparator()
 	{
 		m_items.push_back(nullptr);
@@ -121,10 +131,15 @@ namespace CoreUI
 		if (item && (m_flags & WIN_AUTOSIZE))
 		{
 			Rect itemRect = item->GetRect(true, false);
-			m_height = std::max(itemRect.h, m_height);
+			int height = std::max(itemRect.h, m_height);
 
 			// Clip to sensible value
-			m_height = std::min(128, m_height);
+			height = std::min(128, height);
+			if (height != m_height)
+			{
+				m_height = height;
+				WINMGR().GeometryChanged();
+			}
 		}
 	}
 
@@ -138,11 +153,12 @@ namespace CoreUI
 		return HitZone::HIT_NOTHING;
 	}
 
-	ToolbarItemPtr Toolbar::ItemAt(PointRef pt)
+	ToolbarItemPtr Toolbar::ItemAt(PointRef pt, HitResult & hit)
 	{
 		for (auto & item : m_items)
 		{
-			if (item && item->HitTest(pt))
+			hit = item ? item->HitTest(pt) : HitResult();
+			if (hit)
 			{
 				return item;
 			}
@@ -157,10 +173,11 @@ namespace CoreUI
 		HitResult hit = HitTest(&pt);
 		if (hit)
 		{
-			ToolbarItemPtr item = ItemAt(&pt);
+			HitResult itemHit;
+			ToolbarItemPtr item = ItemAt(&pt, itemHit);
 			if (item)
 			{
-				return item->HandleEvent(e);
+				return item->HandleOwnEvent(e, itemHit);
 			}
 		}
 		return false;
@@ -3,6 +3,7 @@
 #include "Core/Widget.h"
 #include "Core/Rect.h"
 #include "Core/Point.h"
+#include "Util/Signal.h"
 #include <string>
 #include <vector>
 
@@ -35,6 +36,7 @@ namespace CoreUI
 		void AddSeparator();
 
 		bool HandleEvent(SDL_Event *) override;
+		bool HandleOwnEvent(SDL_Event *, const HitResult &) override { return false; } // Items are hit tested directly
 		HitResult HitTest(const PointRef) override;
 
 		void Draw() override {};
@@ -42,16 +44,22 @@ namespace CoreUI
 
 		int GetHeight(int clientWidth) const;
 
+		// Called as soon as an item is clicked, EVENT_TOOLBAR_CLICKED is also posted
+		Signal<ToolbarItemRef> & OnClicked() { return m_onClicked; }
+
 	protected:
 		Toolbar(RendererRef renderer, const char * id, int height, CreationFlags flags = 0);
 
 		ToolbarItems::const_iterator FindByID(const char * id) const;
 		void UpdateSize(ToolbarItemPtr);
 
-		ToolbarItemPtr ItemAt(PointRef pt);
+		ToolbarItemPtr ItemAt(PointRef pt, HitResult & hit);
+		void ItemClicked(ToolbarItemRef item);
 	
 		ToolbarItems m_items;
 		int m_height;
+		Signal<ToolbarItemRef> m_onClicked;
+		std::vector<ScopedConnection> m_itemConnections;
 
 		struct shared_enabler;
 	};
@@ -33,6 +33,20 @@ namespace CoreUI
 		m_drawLocation = *rect;
 	}
 
+	void ToolbarItem::Invalidate()
+	{
+		if (m_parent)
+		{
+			m_parent->ChildInvalidated();
+		}
+
+		// Position only known once drawn by the toolbar
+		if (!m_drawLocation.IsEmpty())
+		{
+			WINMGR().Invalidate(&m_drawLocation);
+		}
+	}
+
 	HitResult ToolbarItem::HitTest(const PointRef pt)
 	{
 		if (m_drawLocation.PointInRect(pt))
@@ -29,6 +29,8 @@ namespace CoreUI
 
 		void Draw(const RectRef);
 
+		void Invalidate() override;
+
 	protected:
 		ToolbarItem(const char* id, RendererRef renderer, const char* label, ImageRef image, FontRef font);
 
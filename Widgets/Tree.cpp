@@ -13,8 +13,11 @@
 
 namespace CoreUI
 {
-	TreeNode::TreeNode(RendererRef renderer, const char* text, ImageRef opened, ImageRef closed, TreeNodeRef parent, TreeRef tree) :
-		m_renderer(renderer), m_text(text), m_openedImage(opened), m_closedImage(closed), m_parent(parent), m_tree(tree), m_depth(0), m_opened(true), m_selected(false)
+	// Horizontal padding around node labels
+	static const int labelPadding = 5;
+
+	TreeNode::TreeNode(const char* text, ImageRef opened, ImageRef closed, TreeNodeRef parent, TreeRef tree) :
+		m_text(text), m_textWidth(-1), m_openedImage(opened), m_closedImage(closed), m_parent(parent), m_index(0), m_tree(tree), m_depth(0), m_opened(true), m_selected(false)
 	{
 		TreeNodeRef curr = parent;
 		while (curr) 
@@ -36,17 +39,9 @@ namespace CoreUI
 		return true;
 	}
 
-	void TreeNode::Render()
+	void TreeNode::SetText(const char * text)
 	{
-		if (!m_label && !m_text.empty())
-		{
-			m_label = Label::CreateAutoSize("l", m_renderer, m_text.c_str());
-			m_label->SetParent(m_tree);
-			m_label->SetPadding(Dimension(5, 0));
-			m_label->SetBorder(false);
-			m_label->SetMargin(0);
-			m_label->Init();
-		}
+		m_tree->SetNodeText(this, text ? text : "");
 	}
 
 	bool TreeNode::Hit(PointRef pt) 
@@ -142,10 +137,16 @@ namespace CoreUI
 		ClipRect clip(m_renderer, &frameRect);
 		if (clip)
 		{
-			DrawTree(&drawRect);
+			DrawTree(&drawRect, clip.GetClipRegion());
 		}
 	}
 
+	Rect Tree::GetDrawRect() const
+	{
+		Rect drawRect = (m_flags & WIN_FILL) ? m_parent->GetClientRect(false, true) : GetRect(false, true);
+		return drawRect.Deflate(GetShrinkFactor());
+	}
+
 	void Tree::DrawBackground(const RectRef &rect)
 	{
 		Rect fillRect = m_rect;
@@ -155,16 +156,16 @@ namespace CoreUI
 		DrawFilledRect(rect, m_backgroundColor);
 	}
 
-	void Tree::DrawTree(const RectRef & rect)
+	void Tree::DrawTree(const RectRef & rect, const RectRef & clip)
 	{
-		int line = 0;
-		for (auto & node : m_nodes)
+		UpdateRows();
+
+		// Only the rows crossing the clip region
+		int first = std::max(0, (clip->y - rect->y) / m_lineHeight);
+		int last = std::min((int)m_rows.Size(), (clip->y + clip->h - rect->y + m_lineHeight - 1) / m_lineHeight);
+		for (int line = first; line < last; ++line)
 		{
-			if (node->IsVisible())
-			{
-				DrawNode(rect, line, node);
-				++line;
-			}
+			DrawNode(rect, line, m_rows[line]);
 		}
 	}
 	
@@ -173,7 +174,7 @@ namespace CoreUI
 		Rect target = *rect;
 		target.x += (m_indent * node->m_depth);
 		target.y += (line * m_lineHeight);
-		target.w = node->m_label->GetRect().w;
+		target.w = GetLabelWidth(node);
 		target.h = m_lineHeight;
 
 		if (node->IsSelected() && (m_flags & TCF_FULLROWSELECT))
@@ -212,11 +213,10 @@ namespace CoreUI
 			target.x += m_lineHeight;
 		}
 
-		if (node->m_label)
+		if (!node->m_text.empty())
 		{
-			node->m_label->SetBackgroundColor(node->IsSelected() ? m_selectedBgColor : m_backgroundColor);
-			node->m_label->SetForegroundColor(node->IsSelected() ? m_selectedFgColor : m_foregroundColor);
-			node->m_label->Draw(&target);
+			LabelPtr label = GetNodeLabel(node);
+			label->Draw(&target);
 			node->m_labelRect = target;
 
 			if (image)
@@ -229,23 +229,12 @@ namespace CoreUI
 
 	void Tree::RenderNodes()
 	{
-		int maxWidth = 0;
-		for (auto & node : m_nodes)
-		{
-			node->Render();
-
-			// TODO: Include everything that will be rendered (image, lines, widgets, etc.)
-			if (node->IsVisible())
-			{
-				int width = node->m_label->GetRect(true, false).w + (m_indent * node->m_depth + (node->m_openedImage ? m_lineHeight : 0));
-				maxWidth = std::max(width, maxWidth);
-			}
-		}
+		UpdateRows();
 
 		if (m_flags & WIN_FILL)
 		{
 			Rect newRect = { 0, 0, 
-				maxWidth + (2 * GetShrinkFactor().w), 
+				m_maxWidth + (2 * GetShrinkFactor().w), 
 				GetVisibleLineCount() * m_lineHeight + (2 * GetShrinkFactor().h) };
 
 			if (!newRect.IsEqual(&m_rect))
@@ -253,21 +242,275 @@ namespace CoreUI
 				m_rect = newRect;
 				if (m_parent)
 				{
+					m_parent->ChildGeometryChanged(this);
 					GetParentWnd()->GetScrollBars()->RefreshScrollBarStatus();
 				}
 			}
 		}
+		Invalidate();
 	}
 
 	int Tree::GetVisibleLineCount()
 	{
-		return (int)std::count_if(m_nodes.begin(), m_nodes.end(), [](TreeNodeRef node) {return node->IsVisible(); });
+		UpdateRows();
+		return (int)m_rows.Size();
+	}
+
+	int Tree::GetNodeWidth(TreeNodeRef node)
+	{
+		// TODO: Include everything that will be rendered (image, lines, widgets, etc.)
+		return GetLabelWidth(node) + (m_indent * node->m_depth + (node->m_openedImage ? m_lineHeight : 0));
+	}
+
+	int Tree::GetLabelWidth(TreeNodeRef node)
+	{
+		if (node->m_text.empty())
+			return 0;
+
+		// Metrics only, same size as the auto size label
+		if (node->m_textWidth < 0)
+		{
+			node->m_textWidth = RES().GetGlyphAtlas().GetTextSize(m_font, node->m_text.c_str()).x;
+		}
+		return node->m_textWidth + (2 * labelPadding);
+	}
+
+	LabelPtr Tree::GetNodeLabel(TreeNodeRef node)
+	{
+		if (node->m_label)
+		{
+			m_labels.splice(m_labels.begin(), m_labels, node->m_labelPos);
+			return node->m_label;
+		}
+
+		LabelPtr label = Label::CreateAutoSize("l", m_renderer, node->m_text.c_str(), m_font);
+		label->SetPadding(Dimension(labelPadding, 0));
+		label->SetBorder(false);
+		label->SetMargin(0);
+		label->Init();
+
+		node->m_label = label;
+		node->m_labelPos = m_labels.insert(m_labels.begin(), node);
+		StyleNodeLabel(node);
+
+		// Created while drawing: parent set last, so setting it up doesn't invalidate the tree
+		label->SetParent(this);
+		m_labelBytes += GetLabelSize(node);
+
+		TrimLabels();
+		return label;
+	}
+
+	void Tree::StyleNodeLabel(TreeNodeRef node)
+	{
+		if (!node->m_label)
+			return;
+
+		bool selected = node->IsSelected();
+		node->m_label->SetBackgroundColor(selected ? m_selectedBgColor : m_backgroundColor);
+		node->m_label->SetForegroundColor(selected ? m_selectedFgColor : m_foregroundColor);
+	}
+
+	void Tree::StyleNodeLabels()
+	{
+		for (TreeNodeRef node : m_labels)
+		{
+			StyleNodeLabel(node);
+		}
+	}
+
+	void Tree::SetForegroundColor(Color color)
+	{
+		Widget::SetForegroundColor(color);
+		StyleNodeLabels();
+	}
+
+	void Tree::SetBackgroundColor(Color color)
+	{
+		Widget::SetBackgroundColor(color);
+		StyleNodeLabels();
+	}
+
+	void Tree::SetSelectedFgColor(Color color)
+	{
+		Widget::SetSelectedFgColor(color);
+		StyleNodeLabels();
+	}
+
+	void Tree::SetSelectedBgColor(Color color)
+	{
+		Widget::SetSelectedBgColor(color);
+		StyleNodeLabels();
+	}
+
+	void Tree::ReleaseLabel(TreeNodeRef node)
+	{
+		if (node->m_label)
+		{
+			m_labelBytes -= GetLabelSize(node);
+			m_labels.erase(node->m_labelPos);
+			node->m_label.reset();
+		}
+	}
+
+	void Tree::TrimLabels()
+	{
+		// Always keep the label just drawn
+		while (m_labels.size() > 1 && 
+			((m_maxLabels && m_labels.size() > m_maxLabels) || (m_maxLabelBytes && m_labelBytes > m_maxLabelBytes)))
+		{
+			ReleaseLabel(m_labels.back());
+		}
+	}
+
+	size_t Tree::GetLabelSize(TreeNodeRef node) const
+	{
+		// Widget and its copies of the text, glyphs themselves are shared in the atlas
+		return sizeof(Label) + (2 * node->m_text.size());
+	}
+
+	void Tree::SetLabelBudget(size_t maxLabels, size_t maxBytes)
+	{
+		m_maxLabels = maxLabels;
+		m_maxLabelBytes = maxBytes;
+		TrimLabels();
+	}
+
+	void Tree::SetNodeText(TreeNodeRef node, const char * text)
+	{
+		// Only shown rows count in the widest row
+		bool shown = !m_rowsDirty && GetRow(node) >= 0;
+		int oldWidth = shown ? GetNodeWidth(node) : 0;
+
+		node->m_text = text;
+		node->m_textWidth = -1;
+
+		// Recreated with the new text on next draw
+		ReleaseLabel(node);
+
+		if (shown)
+		{
+			int width = GetNodeWidth(node);
+			if (width >= m_maxWidth)
+			{
+				m_maxWidth = width;
+			}
+			else if (oldWidth >= m_maxWidth)
+			{
+				// Was the widest row
+				UpdateMaxWidth();
+			}
+		}
+
+		// Content size and scroll bars
+		RenderNodes();
+	}
+
+	void Tree::UpdateMaxWidth()
+	{
+		m_maxWidth = 0;
+		m_rows.ForEach([this](TreeNodeRef node) { m_maxWidth = std::max(m_maxWidth, GetNodeWidth(node)); });
+	}
+
+	void Tree::UpdateRows()
+	{
+		if (!m_rowsDirty)
+			return;
+
+		m_rows.Clear();
+		if (m_root)
+		{
+			TreeNodeList rows;
+			rows.push_back(m_root.get());
+			AddVisibleRows(m_root.get(), rows);
+			m_rows.Insert(0, rows.begin(), rows.end());
+		}
+
+		UpdateMaxWidth();
+		m_rowsDirty = false;
+	}
+
+	void Tree::AddVisibleRows(TreeNodeRef node, TreeNodeList & rows)
+	{
+		if (!node->m_opened)
+			return;
+
+		for (auto & child : node->m_children)
+		{
+			rows.push_back(child.get());
+			AddVisibleRows(child.get(), rows);
+		}
+	}
+
+	int Tree::GetRow(TreeNodeRef node) const
+	{
+		size_t row = m_rows.RowOf(node);
+		return (row == TreeRows::npos) ? -1 : (int)row;
+	}
+
+	size_t Tree::GetSubtreeEnd(TreeNodeRef node)
+	{
+		// Visible descendants are followed by the next sibling of the node, or of
+		// its closest parent having one.  Siblings of a shown node are shown.
+		for (; node->m_parent; node = node->m_parent)
+		{
+			auto & siblings = node->m_parent->m_children;
+			if (node->m_index + 1 < siblings.size())
+			{
+				return m_rows.RowOf(siblings[node->m_index + 1].get());
+			}
+		}
+		return m_rows.Size();
+	}
+
+	void Tree::ShowChildren(TreeNodeRef node)
+	{
+		int row = GetRow(node);
+		if (m_rowsDirty || row < 0)
+			return;
+
+		TreeNodeList shown;
+		AddVisibleRows(node, shown);
+		for (auto & child : shown)
+		{
+			m_maxWidth = std::max(m_maxWidth, GetNodeWidth(child));
+		}
+
+		m_rows.Insert(row + 1, shown.begin(), shown.end());
+	}
+
+	void Tree::HideChildren(TreeNodeRef node)
+	{
+		int row = GetRow(node);
+		if (m_rowsDirty || row < 0)
+			return;
+
+		size_t begin = row + 1;
+		size_t end = GetSubtreeEnd(node);
+
+		bool widest = false;
+		for (size_t i = begin; i < end; ++i)
+		{
+			widest |= (GetNodeWidth(m_rows[i]) >= m_maxWidth);
+		}
+
+		m_rows.Erase(begin, end - begin);
+
+		if (widest)
+		{
+			UpdateMaxWidth();
+		}
 	}
 
 	bool Tree::HandleEvent(SDL_Event * e)
 	{
 		Point pt(e->button.x, e->button.y);
-		HitResult hit = HitTest(&pt);
+		return HandleOwnEvent(e, HitTest(&pt));
+	}
+
+	bool Tree::HandleOwnEvent(SDL_Event * e, const HitResult & hit)
+	{
+		Point pt(e->button.x, e->button.y);
 		switch (e->type)
 		{
 		case SDL_MOUSEMOTION:
@@ -363,10 +606,18 @@ namespace CoreUI
 
 	TreeNodeRef Tree::NodeAt(PointRef pt)
 	{
-		auto it = std::find_if(m_nodes.begin(), m_nodes.end(), [pt](TreeNodeRef node) { return node->IsVisible() && node->Hit(pt); });
-		if (it != m_nodes.end())
+		UpdateRows();
+
+		Rect drawRect = GetDrawRect();
+		if (pt->y < drawRect.y)
+		{
+			return nullptr;
+		}
+
+		size_t row = (pt->y - drawRect.y) / m_lineHeight;
+		if (row < m_rows.Size() && m_rows[row]->Hit(pt))
 		{
-			return *it;
+			return m_rows[row];
 		}
 
 		return nullptr;
@@ -379,8 +630,19 @@ namespace CoreUI
 			throw std::invalid_argument("Node is null");
 		}
 
-		// For efficiency, assume that node belongs to m_nodes...
-		node->m_opened = open;
+		// For efficiency, assume that node belongs to the tree...
+		if (node->m_opened != open)
+		{
+			node->m_opened = open;
+			if (open)
+			{
+				ShowChildren(node);
+			}
+			else
+			{
+				HideChildren(node);
+			}
+		}
 		RenderNodes();
 	}
 
@@ -391,21 +653,20 @@ namespace CoreUI
 			throw std::invalid_argument("Node is null");
 		}
 
-		// For efficiency, assume that node belongs to m_nodes...
-		node->m_opened = !node->m_opened;
-		RenderNodes();
+		OpenNode(node, !node->m_opened);
 	}
 
 	TreeNodeRef Tree::AddRootNode(const char * label, ImageRef opened, ImageRef closed)
 	{
-		if (!m_nodes.empty())
+		if (m_root)
 		{
 			throw std::invalid_argument("tree already has node");
 		}
 
-		TreeNodeRef root = new TreeNode(m_renderer, label, opened, closed, nullptr, this);
-		m_nodes.push_back(root);
-		return root;
+		m_root = std::unique_ptr<TreeNode>(new TreeNode(label, opened, closed, nullptr, this));
+
+		m_rowsDirty = true;
+		return m_root.get();
 	}
 
 	TreeNodeRef Tree::AddNode(const char * label, TreeNodeRef parent)
@@ -430,139 +691,98 @@ namespace CoreUI
 			return AddRootNode(label, opened, closed);
 		}
 
-		auto iter = FindNode(parent);
-		if (iter == m_nodes.end())
+		if (parent->m_tree != this)
 		{
 			throw std::invalid_argument("parent node not found");
 		}
-		while (++iter != m_nodes.end() && (*iter)->GetParent() == parent);
 
-		TreeNodeRef node = new TreeNode(m_renderer, label, opened, closed, parent, this);
-		m_nodes.insert(iter, node);
-		return node;
-	}
+		TreeNodeRef node = new TreeNode(label, opened, closed, parent, this);
+		node->m_index = parent->m_children.size();
+		parent->m_children.push_back(std::unique_ptr<TreeNode>(node));
 
-	TreeNodeList::iterator CoreUI::Tree::FindNode(TreeNodeRef toFind)
-	{
-		return std::find_if(m_nodes.begin(), m_nodes.end(), [toFind](TreeNodeRef node) {return toFind == node; });
+		if (!m_rowsDirty && parent->m_opened && GetRow(parent) >= 0)
+		{
+			// Shown right after the parent's last visible descendant
+			m_rows.Insert(GetSubtreeEnd(parent), node);
+			m_maxWidth = std::max(m_maxWidth, GetNodeWidth(node));
+		}
+
+		return node;
 	}
 
 	bool CoreUI::Tree::NodeHasChildren(TreeNodeRef node)
 	{
-		auto it = FindNode(node);
-		if (it == m_nodes.end())
+		if (node == nullptr || node->m_tree != this)
 		{
 			throw std::invalid_argument("node not found");
 		}
 
-		++it;
-		return (it != m_nodes.end() && (*it)->m_parent == node);
+		return !node->m_children.empty();
 	}
 
 	bool Tree::NodeHasNextSibling(TreeNodeRef node)
 	{
-		auto it = FindNode(node);
-		if (it == m_nodes.end())
+		if (node == nullptr || node->m_tree != this)
 		{
 			throw std::invalid_argument("node not found");
 		}
 
-		while (++it != m_nodes.end())
-		{
-			if ((*it)->m_parent == node->m_parent)
-				return true;
-		}
-		return false;
+		return node->m_parent && (node->m_index + 1 < node->m_parent->m_children.size());
 	}
 
 	bool Tree::NodeHasPreviousSibling(TreeNodeRef node)
 	{
-		auto it = FindNode(node);
-		if (it == m_nodes.end())
+		if (node == nullptr || node->m_tree != this)
 		{
 			throw std::invalid_argument("node not found");
 		}
-		
-		while (it != m_nodes.begin())
-		{
-			--it;
-			if ((*it)->m_parent == node->m_parent)
-				return true;
-		}
-		return false;
+
+		return node->m_parent && (node->m_index > 0);
 	}
 
 	void Tree::SelectNode(TreeNodeRef node)
 	{
-		for (auto & node : m_nodes)
+		if (m_selected)
 		{
-			node->m_selected = false;
+			m_selected->m_selected = false;
+			StyleNodeLabel(m_selected);
 		}
 
+		m_selected = node;
 		if (node)
 		{
 			node->m_selected = true;
+			StyleNodeLabel(node);
 		}
 
-		PostEvent(EVENT_TREE_SELECT, node);
-	}
-
-	TreeNodeList::iterator Tree::FindSelectedNode()
-	{
-		return std::find_if(m_nodes.begin(), m_nodes.end(), [](TreeNodeRef node) { return node->IsSelected(); });
+		Invalidate();
+		PostChangeEvent(EVENT_TREE_SELECT, node);
+		m_onSelected.Emit(node);
 	}
 
 	TreeNodeRef Tree::GetSelectedNode()
 	{
-		auto it = FindSelectedNode();
-		if (it != m_nodes.end())
-		{
-			return *it;
-		}
-
-		return nullptr;
+		return m_selected;
 	}
 
 	void Tree::MoveSelectionRel(int16_t deltaY)
 	{
-		auto it = FindSelectedNode();
+		UpdateRows();
+		if (m_rows.IsEmpty())
+			return;
 
-		if (deltaY < 0 && it != m_nodes.begin())
+		// Start from the selection, or its closest visible parent if it was closed
+		TreeNodeRef from = m_selected;
+		while (from && GetRow(from) < 0)
 		{
-			while (deltaY < 0)
-			{
-				if (--it == m_nodes.begin())
-					break;
-
-				if ((*it)->IsVisible())
-				{
-					++deltaY;
-				}
-			}
+			from = from->m_parent;
 		}
-		else if (deltaY > 0 && it != m_nodes.end())
-		{
-			TreeNodeList::iterator lastVisible = m_nodes.end();
-			while (deltaY > 0)
-			{
-				if (++it == m_nodes.end())
-					break;
 
-				if ((*it)->IsVisible())
-				{
-					lastVisible = it;
-					--deltaY;
-				}
-			}
+		int row = from ? GetRow(from) : 0;
+		row = clip(row + deltaY, 0, (int)m_rows.Size() - 1);
 
-			it = lastVisible;
-		}
-		
-		if (it != m_nodes.end())
-		{
-			SelectNode(*it);
-			ScrollSelectionIntoView();
-		}
+		SelectNode(m_rows[row]);
+		ScrollSelectionIntoView();
 	}
 	void Tree::MoveSelectionPage(int16_t deltaY)
 	{
@@ -588,15 +808,19 @@ namespace CoreUI
 		PointRef scrollPos = parentWnd->GetScrollBars()->GetScrollPos();
 
 		TreeNodeRef selected = GetSelectedNode();
-		if (selected)
+		int row = selected ? GetRow(selected) : -1;
+		if (row >= 0)
 		{
-			int deltaY = selected->m_labelRect.y - rectAbs.y + scrollPos->y;
+			// Row may not have been drawn yet, compute its position
+			int rowY = GetDrawRect().y + (row * m_lineHeight);
+
+			int deltaY = rowY - rectAbs.y + scrollPos->y;
 			if (deltaY < 0)
 			{
 				parentWnd->GetScrollBars()->ScrollRel(&Point(0, deltaY - GetShrinkFactor().h));
 			}
 
-			deltaY = (selected->m_labelRect.y + m_lineHeight - rectAbs.y) - rectAbs.h + scrollPos->y;
+			deltaY = (rowY + m_lineHeight - rectAbs.y) - rectAbs.h + scrollPos->y;
 			if (deltaY > 0)
 			{
 				parentWnd->GetScrollBars()->ScrollRel(&Point(0, deltaY));
@@ -3,12 +3,17 @@
 #include "Core/Rect.h"
 #include "Core/Widget.h"
 #include "Core/WindowManager.h"
-#include <string>
+#include "Util/RowRope.h"
+#include "Util/Signal.h"
 #include <list>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace CoreUI
 {
-	using TreeNodeList = std::list<TreeNodeRef>;
+	using TreeNodeList = std::vector<TreeNodeRef>;
+	using TreeNodeLRU = std::list<TreeNodeRef>;
 
 	enum TreeCreationFlags : CreationFlags 
 	{
@@ -20,8 +25,13 @@ namespace CoreUI
 	class DllExport TreeNode
 	{
 	public:
+		TreeNode(const TreeNode&) = delete;
+		TreeNode& operator=(const TreeNode&) = delete;
+		TreeNode(TreeNode&&) = delete;
+		TreeNode& operator=(TreeNode&&) = delete;
+
 		std::string GetText() const { return m_text; }
-		void SetText(const char * text) { m_text = text ? text : ""; Render(); }
+		void SetText(const char * text);
 
 		TreeNodeRef GetParent() const { return m_parent; }
 
@@ -35,24 +45,29 @@ namespace CoreUI
 		bool m_opened;
 		bool m_selected;
 
-		TreeNode(RendererRef renderer, const char* label, ImageRef opened, ImageRef closed, TreeNodeRef parent, TreeRef tree);
-		void Render();
+		TreeNode(const char* label, ImageRef opened, ImageRef closed, TreeNodeRef parent, TreeRef tree);
 
 		ImageRef m_openedImage;
 		ImageRef m_closedImage;
 		
 		TreeNodeRef m_parent;
+		std::vector<std::unique_ptr<TreeNode>> m_children;
+		size_t m_index; // Position in parent's children
+		RowPosition m_row; // In the tree's visible rows, unset if hidden
 
 		std::string m_text;
+		int m_textWidth; // -1 until measured
+
+		// Created when the node is drawn, released when the tree's label budget is exceeded
 		LabelPtr m_label;
+		TreeNodeLRU::iterator m_labelPos;
+
 		Rect m_labelRect;
 		Rect m_buttonRect;
 
 		TreeRef m_tree;
 		int m_depth;
 
-		RendererRef m_renderer;
-
 		friend class Tree;
 	};
 
@@ -77,15 +92,28 @@ namespace CoreUI
 		void SetIndent(int indent) { m_indent = clip(indent, 0, 255); }
 		int GetIndent() const { return m_indent; }
 
+		// Limits the node labels kept between draws, by count and/or approximate size in bytes.
+		// 0 means no limit.  Least recently drawn labels are released first.
+		void SetLabelBudget(size_t maxLabels, size_t maxBytes = 0);
+		size_t GetLabelCount() const { return m_labels.size(); }
+		size_t GetLabelBytes() const { return m_labelBytes; }
+
 		// Creates a tree that fills the whole parent window
 		static TreePtr CreateFill(const char* id, RendererRef renderer, int lineHeight = 20, FontRef font = nullptr, CreationFlags flags = WIN_FILL);
 
 		WindowRef GetParentWnd() { return dynamic_cast<WindowRef>(m_parent); }
 
 		bool HandleEvent(SDL_Event *) override;
+		bool HandleOwnEvent(SDL_Event *, const HitResult &) override;
 		HitResult HitTest(const PointRef) override;
 		void Draw() override;
 
+		// Node labels take the tree's colors
+		void SetForegroundColor(Color color) override;
+		void SetBackgroundColor(Color color) override;
+		void SetSelectedFgColor(Color color) override;
+		void SetSelectedBgColor(Color color) override;
+
 		TreeNodeRef AddNode(const char * label, TreeNodeRef parent = nullptr);
 		TreeNodeRef AddNode(const char * label, ImageRef image, TreeNodeRef parent = nullptr);
 		TreeNodeRef AddNode(const char * label, ImageRef opened, ImageRef closed, TreeNodeRef parent = nullptr);
@@ -100,6 +128,9 @@ namespace CoreUI
 		void SelectNode(TreeNodeRef node);
 		TreeNodeRef GetSelectedNode();
 
+		// Called as soon as the selection changes, EVENT_TREE_SELECT is still posted
+		Signal<TreeNodeRef> & OnSelected() { return m_onSelected; }
+
 		void MoveSelectionRel(int16_t deltaY);
 		void MoveSelectionPage(int16_t deltaY);
 		void OpenSelection();
@@ -111,22 +142,57 @@ namespace CoreUI
 		void RenderNodes();
 		int GetVisibleLineCount();
 
+		// Visible rows
+		void UpdateRows();
+		void AddVisibleRows(TreeNodeRef node, TreeNodeList & rows);
+		void ShowChildren(TreeNodeRef node);
+		void HideChildren(TreeNodeRef node);
+		int GetRow(TreeNodeRef node) const; // -1 if hidden
+		size_t GetSubtreeEnd(TreeNodeRef node);
+		void UpdateMaxWidth();
+		int GetNodeWidth(TreeNodeRef node);
+		void SetNodeText(TreeNodeRef node, const char * text);
+
+		// Node labels
+		int GetLabelWidth(TreeNodeRef node);
+		LabelPtr GetNodeLabel(TreeNodeRef node);
+		void StyleNodeLabel(TreeNodeRef node); // When created and when the selection or colors change, not when drawn
+		void StyleNodeLabels();
+		void ReleaseLabel(TreeNodeRef node);
+		void TrimLabels();
+		size_t GetLabelSize(TreeNodeRef node) const;
+
+		Rect GetDrawRect() const;
 		Rect DrawFrame(const CoreUI::RectRef &rect);
 		void DrawBackground(const CoreUI::RectRef &rect);
-		void DrawTree(const CoreUI::RectRef &rect);
+		void DrawTree(const CoreUI::RectRef &rect, const CoreUI::RectRef &clip);
 		void DrawNode(const CoreUI::RectRef &rect, int line, TreeNodeRef node);
-		TreeNodeList::iterator FindNode(TreeNodeRef);
-		TreeNodeList::iterator FindSelectedNode();
 		TreeNodeRef AddRootNode(const char * label, ImageRef opened, ImageRef closed);
 		TreeNodeRef NodeAt(PointRef pt);
 
 		void ScrollSelectionIntoView();
 
-		TreeNodeList m_nodes;
+		std::unique_ptr<TreeNode> m_root;
+		TreeNodeRef m_selected = nullptr;
+		Signal<TreeNodeRef> m_onSelected;
+
+		// Flattened list of the nodes that are shown, in display order.  Opening and closing
+		// a node splices its subtree in or out, added nodes are inserted at their row.
+		// Adding the root marks the list dirty and it's rebuilt on next use.
+		using TreeRows = RowRope<TreeNode, &TreeNode::m_row>;
+		TreeRows m_rows;
+		bool m_rowsDirty = false;
+		int m_maxWidth = 0; // Widest visible row
+
+		TreeNodeLRU m_labels; // Nodes with a label, most recently drawn first
+		size_t m_labelBytes = 0;
+		size_t m_maxLabels = 256;
+		size_t m_maxLabelBytes = 0;
 
 		int m_lineHeight;
 		int m_indent;
 
 		struct shared_enabler;
+		friend class TreeNode;
 	};
 }
\ No newline at end of file